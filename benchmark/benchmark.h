@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+#include <agz/d3d12/base.h>
+
+#ifdef _WIN32
+#include <dxgi1_4.h>
+#include <agz/d3d12/common.h>
+#endif
+
+namespace bench
+{
+
+    using namespace agz::d3d12;
+
+    class Timer
+    {
+    public:
+
+        Timer() noexcept
+            : start_(std::chrono::steady_clock::now())
+        {
+
+        }
+
+        double seconds() const noexcept
+        {
+            const auto end = std::chrono::steady_clock::now();
+            return std::chrono::duration<double>(end - start_).count();
+        }
+
+    private:
+
+        std::chrono::steady_clock::time_point start_;
+    };
+
+#ifdef _WIN32
+
+    /**
+     * @brief create a device without window. falls back to warp when no
+     *  hardware adapter supports d3d12
+     */
+    inline ComPtr<ID3D12Device> createHeadlessDevice()
+    {
+        ComPtr<ID3D12Device> device;
+        if(SUCCEEDED(D3D12CreateDevice(
+            nullptr, D3D_FEATURE_LEVEL_11_0,
+            IID_PPV_ARGS(device.GetAddressOf()))))
+            return device;
+
+        ComPtr<IDXGIFactory4> dxgiFactory;
+        AGZ_D3D12_CHECK_HR_MSG(
+            "failed to create dxgi factory",
+            CreateDXGIFactory1(IID_PPV_ARGS(dxgiFactory.GetAddressOf())));
+
+        ComPtr<IDXGIAdapter> warp;
+        AGZ_D3D12_CHECK_HR_MSG(
+            "failed to enumerate warp adapter",
+            dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(warp.GetAddressOf())));
+
+        AGZ_D3D12_CHECK_HR_MSG(
+            "failed to create d3d12 device",
+            D3D12CreateDevice(
+                warp.Get(), D3D_FEATURE_LEVEL_11_0,
+                IID_PPV_ARGS(device.GetAddressOf())));
+
+        return device;
+    }
+
+#endif
+
+    inline void report(const char *name, double count, double seconds)
+    {
+        std::printf(
+            "%-40s %12.0f ops in %8.3f ms, %14.0f ops/s\n",
+            name, count, seconds * 1000, count / seconds);
+    }
+
+} // namespace bench
@@ -0,0 +1,102 @@
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <agz/d3d12/asset/chunkedLZ4.h>
+#include <agz/d3d12/asset/lz4.h>
+
+#include "./benchmark.h"
+
+using namespace agz::d3d12;
+
+namespace
+{
+    constexpr size_t DATA_SIZE = size_t(64) << 20;
+    constexpr int    ROUNDS    = 4;
+
+    constexpr double MB = 1024.0 * 1024.0;
+
+    // words with random numbers in between, which compress to about half
+    // like typical mesh & text assets
+    std::vector<unsigned char> generateData()
+    {
+        const char *words[] =
+        {
+            "vertex ", "normal ", "texcoord ", "index ", "material ",
+            "diffuse ", "specular ", "roughness ", "metallic ", "\n"
+        };
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> wordDis(0, 9);
+        std::uniform_int_distribution<int> byteDis(0, 255);
+
+        std::vector<unsigned char> ret;
+        ret.reserve(DATA_SIZE);
+        while(ret.size() < DATA_SIZE)
+        {
+            const char *word = words[wordDis(rng)];
+            ret.insert(ret.end(), word, word + std::strlen(word));
+            for(int i = 0; i < 4; ++i)
+                ret.push_back(static_cast<unsigned char>(byteDis(rng)));
+        }
+        ret.resize(DATA_SIZE);
+
+        return ret;
+    }
+
+} // namespace anonymous
+
+int main()
+{
+    const auto data = generateData();
+
+    // compression
+
+    std::vector<unsigned char> compressed;
+    {
+        bench::Timer timer;
+        for(int r = 0; r < ROUNDS; ++r)
+            compressed = compressChunkedLZ4(data.data(), data.size());
+        const double seconds = timer.seconds();
+
+        bench::report(
+            "compressChunkedLZ4 (MB)", ROUNDS * DATA_SIZE / MB, seconds);
+    }
+
+    std::printf(
+        "compressed to %.1f%% of %.0f MB\n",
+        100.0 * compressed.size() / data.size(), DATA_SIZE / MB);
+
+    // decompression. memcpy of the same size is the upper bound
+
+    const ChunkedLZ4View view(compressed.data(), compressed.size());
+    std::vector<unsigned char> output(DATA_SIZE);
+
+    {
+        bench::Timer timer;
+        for(int r = 0; r < ROUNDS; ++r)
+            std::memcpy(output.data(), data.data(), DATA_SIZE);
+        const double seconds = timer.seconds();
+
+        bench::report("memcpy (MB)", ROUNDS * DATA_SIZE / MB, seconds);
+    }
+
+    {
+        bench::Timer timer;
+        for(int r = 0; r < ROUNDS; ++r)
+            view.decompress(output.data());
+        const double seconds = timer.seconds();
+
+        bench::report(
+            "ChunkedLZ4View::decompress (MB)",
+            ROUNDS * DATA_SIZE / MB, seconds);
+    }
+
+    if(output != data)
+    {
+        std::printf("decompressed data mismatches source\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include <agz/d3d12/asset/mappedFile.h>
+
+#include "./benchmark.h"
+
+using namespace agz::d3d12;
+
+namespace
+{
+    constexpr size_t FILE_SIZE  = size_t(64) << 20;
+    constexpr size_t CHUNK_SIZE = size_t(4)  << 20;
+    constexpr int    ROUNDS     = 8;
+
+    constexpr double MB = 1024.0 * 1024.0;
+
+    // destination of copies, standing for a staging ring
+    std::vector<unsigned char> staging(CHUNK_SIZE);
+
+    volatile unsigned char sink;
+
+    void writeFile(const std::string &filename)
+    {
+        std::vector<unsigned char> data(FILE_SIZE);
+        std::mt19937 rng(42);
+        for(auto &b : data)
+            b = static_cast<unsigned char>(rng());
+
+        std::ofstream fout(
+            filename, std::ofstream::out | std::ofstream::binary);
+        fout.write(reinterpret_cast<const char *>(data.data()), data.size());
+        if(!fout)
+            throw D3D12LabException("failed to write " + filename);
+    }
+
+    void copyToStaging(const unsigned char *data, size_t size)
+    {
+        for(size_t offset = 0; offset < size; offset += CHUNK_SIZE)
+        {
+            const size_t n = (std::min)(CHUNK_SIZE, size - offset);
+            std::memcpy(staging.data(), data + offset, n);
+            sink = staging[0];
+        }
+    }
+
+    // read the whole file into a heap vector, then copy it to staging
+    void readWithStream(const std::string &filename)
+    {
+        std::ifstream fin(filename, std::ifstream::in | std::ifstream::binary);
+        std::vector<unsigned char> data(FILE_SIZE);
+        fin.read(reinterpret_cast<char *>(data.data()), data.size());
+        if(!fin)
+            throw D3D12LabException("failed to read " + filename);
+
+        copyToStaging(data.data(), data.size());
+    }
+
+    // copy from the mapping to staging, prefetching the next chunk
+    void readWithMapping(const std::string &filename)
+    {
+        MappedFile file(filename);
+        file.adviseSequential();
+
+        const unsigned char *data = file.getData();
+        for(size_t offset = 0; offset < file.getSize(); offset += CHUNK_SIZE)
+        {
+            file.prefetch(offset + CHUNK_SIZE, CHUNK_SIZE);
+
+            const size_t n = (std::min)(CHUNK_SIZE, file.getSize() - offset);
+            std::memcpy(staging.data(), data + offset, n);
+            sink = staging[0];
+        }
+    }
+
+    template<typename Func>
+    void run(const char *name, const std::string &filename, Func &&func)
+    {
+        // warm up page cache, so both paths read from it
+        func(filename);
+
+        bench::Timer timer;
+        for(int r = 0; r < ROUNDS; ++r)
+            func(filename);
+        const double seconds = timer.seconds();
+
+        bench::report(name, ROUNDS * FILE_SIZE / MB, seconds);
+    }
+
+} // namespace anonymous
+
+int main()
+{
+    const std::string filename = (
+        std::filesystem::temp_directory_path() /
+        "d3d12lab_mapped_file_benchmark.bin").string();
+
+    writeFile(filename);
+
+    try
+    {
+        run("ifstream + copy (MB)", filename, readWithStream);
+        run("MappedFile copy (MB)", filename, readWithMapping);
+    }
+    catch(const std::exception &e)
+    {
+        std::printf("%s\n", e.what());
+        std::filesystem::remove(filename);
+        return 1;
+    }
+
+    std::filesystem::remove(filename);
+    return 0;
+}
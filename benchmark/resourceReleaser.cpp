@@ -0,0 +1,77 @@
+#include <agz/d3d12/framegraph/resourceReleaser.h>
+
+#include <d3dx12.h>
+
+#include "./benchmark.h"
+
+using namespace agz::d3d12;
+
+namespace
+{
+    constexpr int FRAME_COUNT        = 1000;
+    constexpr int RELEASES_PER_FRAME = 100;
+
+    // retirements per second the frame graph must sustain
+    constexpr double TARGET_RATE = 100000;
+
+    ComPtr<ID3D12Resource> createBuffer(ID3D12Device *device)
+    {
+        const CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
+        const auto desc = CD3DX12_RESOURCE_DESC::Buffer(256);
+
+        ComPtr<ID3D12Resource> rsc;
+        AGZ_D3D12_CHECK_HR(
+            device->CreateCommittedResource(
+                &heapProps,
+                D3D12_HEAP_FLAG_NONE,
+                &desc,
+                D3D12_RESOURCE_STATE_COMMON,
+                nullptr,
+                IID_PPV_ARGS(rsc.GetAddressOf())));
+        return rsc;
+    }
+
+} // namespace anonymous
+
+int main()
+{
+    auto device = bench::createHeadlessDevice();
+
+    ComPtr<ID3D12CommandQueue> queue;
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    AGZ_D3D12_CHECK_HR(
+        device->CreateCommandQueue(
+            &queueDesc, IID_PPV_ARGS(queue.GetAddressOf())));
+
+    // every record holds a reference of the same rsc, so the benchmark
+    // measures bookkeeping of the releaser instead of rsc destruction
+
+    auto rsc = createBuffer(device.Get());
+
+    bench::Timer timer;
+    {
+        fg::ResourceReleaser releaser(device.Get());
+        for(int f = 0; f < FRAME_COUNT; ++f)
+        {
+            for(int i = 0; i < RELEASES_PER_FRAME; ++i)
+                releaser.add(rsc);
+
+            releaser.addReleasePoint(queue.Get());
+            releaser.collect();
+        }
+
+        // destructor waits for the last release point and retires the rest
+    }
+    const double seconds = timer.seconds();
+
+    const double count = double(FRAME_COUNT) * RELEASES_PER_FRAME;
+    bench::report("ResourceReleaser retirements", count, seconds);
+
+    if(count / seconds < TARGET_RATE)
+    {
+        std::printf("below target rate of %.0f/s\n", TARGET_RATE);
+        return 1;
+    }
+
+    return 0;
+}
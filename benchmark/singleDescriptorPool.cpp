@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <agz/d3d12/descriptor/singleDescriptorPool.h>
+#include <agz/utility/container.h>
+
+#include "./benchmark.h"
+
+using namespace agz::d3d12;
+
+namespace
+{
+    constexpr DescriptorCount CAPACITY    = 65536;
+    constexpr int             ROUND_COUNT = 50;
+
+    // fill the heap, then repeatedly free a random half of the slots and
+    // allocate them again. returns number of alloc and free calls
+    template<typename Alloc, typename Free, typename Handle>
+    double run(Alloc &&alloc, Free &&free, std::vector<Handle> &handles)
+    {
+        std::mt19937 rng(42);
+        double opCount = 0;
+
+        handles.clear();
+        for(DescriptorCount i = 0; i < CAPACITY; ++i)
+            handles.push_back(alloc());
+        opCount += CAPACITY;
+
+        for(int r = 0; r < ROUND_COUNT; ++r)
+        {
+            std::shuffle(handles.begin(), handles.end(), rng);
+
+            for(DescriptorCount i = CAPACITY / 2; i < CAPACITY; ++i)
+                free(handles[i]);
+            for(DescriptorCount i = CAPACITY / 2; i < CAPACITY; ++i)
+                handles[i] = alloc();
+            opCount += CAPACITY;
+        }
+
+        for(auto &h : handles)
+            free(h);
+        opCount += CAPACITY;
+
+        return opCount;
+    }
+
+    void benchmarkIntervalMgr()
+    {
+        agz::container::interval_mgr_t<DescriptorIndex> mgr;
+        mgr.free(0, CAPACITY);
+
+        std::vector<DescriptorIndex> handles;
+        handles.reserve(CAPACITY);
+
+        bench::Timer timer;
+        const double opCount = run(
+            [&] { return *mgr.alloc(1); },
+            [&](DescriptorIndex idx) { mgr.free(idx, idx + 1); },
+            handles);
+        bench::report("interval_mgr_t", opCount, timer.seconds());
+    }
+
+    void benchmarkSubHeap(ID3D12Device *device)
+    {
+        DescriptorHeap heap;
+        heap.initialize(
+            device, CAPACITY, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, false);
+
+        std::vector<Descriptor> handles;
+        handles.reserve(CAPACITY);
+
+        bench::Timer timer;
+        const double opCount = run(
+            [&] { return heap.allocSingle(); },
+            [&](const Descriptor &d) { heap.freeSingle(d); },
+            handles);
+        bench::report("DescriptorSubHeap single", opCount, timer.seconds());
+    }
+
+    void benchmarkPool(ID3D12Device *device)
+    {
+        DescriptorHeap heap;
+        heap.initialize(
+            device, CAPACITY, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, false);
+
+        SingleDescriptorPool pool;
+        pool.initialize(heap.allocRange(CAPACITY));
+
+        std::vector<PooledDescriptor> handles;
+        handles.reserve(CAPACITY);
+
+        bench::Timer timer;
+        const double opCount = run(
+            [&] { return pool.alloc(); },
+            [&](const PooledDescriptor &d) { pool.free(d); },
+            handles);
+        bench::report("SingleDescriptorPool", opCount, timer.seconds());
+    }
+
+} // namespace anonymous
+
+int main()
+{
+    auto device = bench::createHeadlessDevice();
+
+    benchmarkIntervalMgr();
+    benchmarkSubHeap(device.Get());
+    benchmarkPool(device.Get());
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <agz/d3d12/base.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief read-only view of data compressed as independent lz4 chunks
+ *
+ * layout: header | chunk table | chunk data
+ *
+ * every chunk except the last one decompresses to chunkSize bytes, so chunks
+ *  can be decompressed in parallel into their final places. a chunk whose
+ *  compressed size equals its decompressed size is stored uncompressed.
+ *
+ * the view does not own the data.
+ */
+class ChunkedLZ4View
+{
+public:
+
+    static constexpr uint32_t DEFAULT_CHUNK_SIZE = 256 * 1024;
+
+    struct Chunk
+    {
+        const unsigned char *data = nullptr;
+
+        uint32_t compressedSize     = 0;
+        uint32_t decompressedSize   = 0;
+        uint64_t decompressedOffset = 0;
+
+        bool isStored() const noexcept;
+    };
+
+    ChunkedLZ4View() noexcept;
+
+    /**
+     * @brief validate header and chunk table. throws when data is malformed
+     */
+    ChunkedLZ4View(const void *data, size_t byteSize);
+
+    uint64_t getDecompressedSize() const noexcept;
+
+    uint32_t getChunkSize() const noexcept;
+
+    uint32_t getChunkCount() const noexcept;
+
+    Chunk getChunk(uint32_t index) const noexcept;
+
+    /**
+     * @brief decompress a chunk to dst, which has chunk.decompressedSize bytes
+     */
+    void decompressChunk(uint32_t index, void *dst) const;
+
+    /**
+     * @brief decompress all chunks to dst on calling thread
+     */
+    void decompress(void *dst) const;
+
+private:
+
+    const unsigned char *data_;
+
+    uint64_t decompressedSize_;
+    uint32_t chunkSize_;
+    uint32_t chunkCount_;
+};
+
+/**
+ * @brief compress data into independent lz4 chunks readable by ChunkedLZ4View
+ */
+std::vector<unsigned char> compressChunkedLZ4(
+    const void *data,
+    size_t      byteSize,
+    uint32_t    chunkSize = ChunkedLZ4View::DEFAULT_CHUNK_SIZE);
+
+AGZ_D3D12_END
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+#include <agz/d3d12/base.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief max size of lz4 block compressed from srcSize bytes
+ */
+constexpr size_t lz4CompressBound(size_t srcSize) noexcept
+{
+    return srcSize + srcSize / 255 + 16;
+}
+
+/**
+ * @brief compress into a raw lz4 block (no frame header)
+ *
+ * greedy single-probe matching, which favors speed over ratio. returns size
+ *  of compressed data, or 0 when it does not fit in dstCapacity
+ */
+size_t lz4Compress(
+    const void *src, size_t srcSize, void *dst, size_t dstCapacity) noexcept;
+
+/**
+ * @brief decompress a raw lz4 block of exactly dstSize decompressed bytes
+ *
+ * returns false when the block is malformed. never reads or writes out of
+ *  given ranges
+ */
+bool lz4Decompress(
+    const void *src, size_t srcSize, void *dst, size_t dstSize) noexcept;
+
+AGZ_D3D12_END
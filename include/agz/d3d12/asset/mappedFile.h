@@ -0,0 +1,69 @@
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include <string>
+
+#include <agz/d3d12/base.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief read-only memory mapping of a whole file
+ *
+ * pages are read from page cache on first access, so copying from the
+ *  mapping reads each byte only once. 'prefetch' asks the os to read a range
+ *  ahead (madvise WILLNEED on posix, PrefetchVirtualMemory on windows) so the
+ *  copy does not stall on page faults.
+ */
+class MappedFile : public misc::uncopyable_t
+{
+public:
+
+    MappedFile() noexcept;
+
+    explicit MappedFile(const std::string &filename);
+
+    MappedFile(MappedFile &&other) noexcept;
+
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    ~MappedFile();
+
+    void swap(MappedFile &other) noexcept;
+
+    void open(const std::string &filename);
+
+    bool isOpen() const noexcept;
+
+    void close();
+
+    const unsigned char *getData() const noexcept;
+
+    size_t getSize() const noexcept;
+
+    /**
+     * @brief hint that the file is mostly read from front to back
+     */
+    void adviseSequential();
+
+    /**
+     * @brief start reading [offset, offset + size) into page cache without
+     *  waiting for it
+     */
+    void prefetch(size_t offset, size_t size);
+
+private:
+
+    const unsigned char *data_;
+    size_t size_;
+
+#ifdef _WIN32
+    HANDLE file_;
+    HANDLE mapping_;
+#endif
+};
+
+AGZ_D3D12_END
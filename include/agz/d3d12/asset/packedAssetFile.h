@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <agz/d3d12/asset/mappedFile.h>
+#include <agz/d3d12/sync/resourceUploader.h>
+
+AGZ_D3D12_BEGIN
+
+enum class PackedAssetType : uint32_t
+{
+    Buffer    = 0,
+    Texture2D = 1
+};
+
+/**
+ * @brief description of an asset in packed asset file
+ *
+ * texture data is stored subrsc by subrsc in d3d12 subrsc order, each with
+ *  tightly packed rows of blocks. format, width, height, arraySize and
+ *  mipLevels are unused by buffers.
+ */
+struct PackedAssetEntry
+{
+    static constexpr size_t MAX_NAME_LENGTH = 63;
+
+    char            name[MAX_NAME_LENGTH + 1] = {};
+    PackedAssetType type      = PackedAssetType::Buffer;
+    uint32_t        format    = DXGI_FORMAT_UNKNOWN;
+    uint32_t        width     = 0;
+    uint32_t        height    = 0;
+    uint32_t        arraySize = 0;
+    uint32_t        mipLevels = 0;
+    uint64_t        offset    = 0;
+    uint64_t        size      = 0;
+};
+
+/**
+ * @brief read-only packed asset file, streamed from a memory mapping
+ *
+ * layout: header | entry table | data of each entry
+ *
+ * uploads read texture rows directly from the mapping into the staging ring
+ *  of ResourceUploader at the placed footprint's row pitch, so each byte is
+ *  copied only once between page cache and upload memory.
+ */
+class PackedAssetFile : public misc::uncopyable_t
+{
+public:
+
+    PackedAssetFile() = default;
+
+    explicit PackedAssetFile(const std::string &filename);
+
+    void open(const std::string &filename);
+
+    bool isOpen() const noexcept;
+
+    void close();
+
+    size_t getEntryCount() const noexcept;
+
+    const PackedAssetEntry &getEntry(size_t index) const noexcept;
+
+    /**
+     * @brief returns nullptr if no entry has given name
+     */
+    const PackedAssetEntry *find(const std::string &name) const noexcept;
+
+    const unsigned char *getData(const PackedAssetEntry &entry) const noexcept;
+
+    /**
+     * @brief start reading data of entry into page cache
+     *
+     * typically called on the next entries while uploading the current one
+     */
+    void prefetch(const PackedAssetEntry &entry);
+
+    /**
+     * @brief desc of a default heap texture to upload entry into
+     */
+    D3D12_RESOURCE_DESC getTex2DDesc(
+        const PackedAssetEntry &entry,
+        D3D12_RESOURCE_FLAGS    flags = D3D12_RESOURCE_FLAG_NONE) const;
+
+    /**
+     * @brief subrsc init data pointing into the mapping
+     */
+    std::vector<ResourceUploader::Tex2DSubInitData> getTex2DSubInitData(
+        const PackedAssetEntry &entry) const;
+
+    void uploadBuffer(
+        ResourceUploader       &uploader,
+        const PackedAssetEntry &entry,
+        ComPtr<ID3D12Resource>  dst,
+        D3D12_RESOURCE_STATES   afterState);
+
+    void uploadTex2D(
+        ResourceUploader       &uploader,
+        const PackedAssetEntry &entry,
+        ComPtr<ID3D12Resource>  dst,
+        D3D12_RESOURCE_STATES   afterState);
+
+private:
+
+    MappedFile file_;
+
+    std::vector<PackedAssetEntry> entries_;
+
+    std::map<std::string, size_t> nameToEntry_;
+};
+
+/**
+ * @brief build a packed asset file in memory and write it to disk
+ */
+class PackedAssetWriter
+{
+public:
+
+    void addBuffer(const std::string &name, const void *data, size_t byteSize);
+
+    /**
+     * @brief subrscData contains arraySize * mipLevels tightly packed subrscs
+     *  in d3d12 subrsc order
+     */
+    void addTex2D(
+        const std::string  &name,
+        DXGI_FORMAT         format,
+        uint32_t            width,
+        uint32_t            height,
+        uint32_t            arraySize,
+        uint32_t            mipLevels,
+        const void * const *subrscData);
+
+    void write(const std::string &filename) const;
+
+private:
+
+    PackedAssetEntry &newEntry(const std::string &name, PackedAssetType type);
+
+    void appendData(PackedAssetEntry &entry, const void *data, size_t size);
+
+    std::vector<PackedAssetEntry> entries_;
+
+    // entry offsets are relative to data_ until written
+    std::vector<unsigned char> data_;
+};
+
+AGZ_D3D12_END
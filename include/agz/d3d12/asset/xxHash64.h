@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <agz/d3d12/common.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief streaming xxHash64
+ *
+ * data fed by multiple 'update' calls hashes the same as when it is fed at
+ *  once.
+ */
+class XXHash64
+{
+public:
+
+    explicit XXHash64(uint64_t seed = 0) noexcept;
+
+    void reset(uint64_t seed = 0) noexcept;
+
+    void update(const void *data, size_t byteSize) noexcept;
+
+    uint64_t digest() const noexcept;
+
+private:
+
+    uint64_t acc_[4];
+    uint64_t seed_;
+    uint64_t totalSize_;
+
+    unsigned char buffer_[32];
+    size_t bufferSize_;
+};
+
+uint64_t xxHash64(const void *data, size_t byteSize, uint64_t seed = 0) noexcept;
+
+AGZ_D3D12_END
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdexcept>
+
+#include <agz/utility/misc.h>
+
+// namespace & exception shared by all modules. unlike common.h, it includes no
+// d3d12 header, so platform-independent modules can be built without d3d12
+
+#define AGZ_D3D12_BEGIN namespace agz::d3d12 {
+#define AGZ_D3D12_END   }
+
+AGZ_D3D12_BEGIN
+
+class D3D12LabException : public std::runtime_error
+{
+public:
+
+    using runtime_error::runtime_error;
+};
+
+AGZ_D3D12_END
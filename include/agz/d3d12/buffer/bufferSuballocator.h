@@ -0,0 +1,131 @@
+#pragma once
+
+#include <map>
+
+#include <d3d12.h>
+
+#include <agz/d3d12/buffer/sizeClassAllocator.h>
+#include <agz/d3d12/memory/allocationStats.h>
+#include <agz/utility/misc.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief (resource, offset, size) view into a buffer block
+ */
+struct BufferRange
+{
+    ID3D12Resource *resource = nullptr;
+
+    UINT64 offset = 0;
+    UINT64 size   = 0;
+
+    // mapped address of offset. nullptr for default heap
+    void *mappedData = nullptr;
+
+    bool isAvailable() const noexcept { return resource != nullptr; }
+
+    D3D12_GPU_VIRTUAL_ADDRESS getGPUVirtualAddress() const noexcept
+        { return resource->GetGPUVirtualAddress() + offset; }
+
+    // first element index of a structured view into this range
+    UINT64 getFirstElement(UINT elemSize) const noexcept
+        { return offset / elemSize; }
+
+    // filled by BufferSuballocator
+    bool dedicated = false;
+    SizeClassAllocator::Allocation allocation;
+};
+
+/**
+ * @brief hands out buffer ranges from large committed blocks
+ *
+ * requests no larger than the max size class share blocks of 'blockSize'
+ *  bytes. larger ones get dedicated resources. use one suballocator for each
+ *  heap type, since blocks of different heap types can not be shared.
+ *
+ * all blocks of the default heap are created in COMMON state and rely on the
+ *  implicit promotion/decay of buffers, as ranges in the same block can not
+ *  have different explicit states.
+ *
+ * meant for long-lived small buffers, like constant or argument buffers
+ *  filled by ResourceUploader::uploadBufferData(const BufferRange&, ...).
+ *  staging space of uploads comes from the fenced ring of ResourceUploader,
+ *  and internal buffers of frame graph stay dedicated rscs, since the graph
+ *  transitions each of them to its own state.
+ *
+ * NOT thread-safe.
+ */
+class BufferSuballocator : public misc::uncopyable_t
+{
+public:
+
+    static constexpr UINT64 DEFAULT_BLOCK_SIZE     = 4 * 1024 * 1024;
+    static constexpr UINT64 DEFAULT_MIN_CLASS_SIZE = 256;
+    static constexpr UINT64 DEFAULT_MAX_CLASS_SIZE = 64 * 1024;
+
+    /**
+     * @param flags resource flags of blocks, like ALLOW_UNORDERED_ACCESS
+     */
+    BufferSuballocator(
+        ComPtr<ID3D12Device> device,
+        D3D12_HEAP_TYPE      heapType,
+        D3D12_RESOURCE_FLAGS flags        = D3D12_RESOURCE_FLAG_NONE,
+        UINT64               blockSize    = DEFAULT_BLOCK_SIZE,
+        UINT64               minClassSize = DEFAULT_MIN_CLASS_SIZE,
+        UINT64               maxClassSize = DEFAULT_MAX_CLASS_SIZE);
+
+    ~BufferSuballocator();
+
+    /**
+     * @brief allocate a range of at least 'size' bytes
+     *
+     * offset of returned range is aligned to
+     *  D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT
+     */
+    BufferRange alloc(UINT64 size);
+
+    /**
+     * @brief give a range back
+     *
+     * the caller must make sure that gpu no longer accesses the range,
+     *  e.g. by delaying the call until a fence is reached
+     */
+    void free(const BufferRange &range);
+
+    D3D12_HEAP_TYPE getHeapType() const noexcept;
+
+    D3D12_RESOURCE_STATES getInitialState() const noexcept;
+
+    /**
+     * @brief counter of d3d12 buffers (blocks and dedicated ones) created by
+     *  this suballocator
+     */
+    const AllocationCounter &getCounter() const noexcept;
+
+private:
+
+    struct BlockRsc
+    {
+        ComPtr<ID3D12Resource> rsc;
+        char *mappedData = nullptr;
+    };
+
+    BlockRsc createBuffer(UINT64 size);
+
+    ComPtr<ID3D12Device> device_;
+
+    D3D12_HEAP_TYPE       heapType_;
+    D3D12_RESOURCE_FLAGS  flags_;
+    D3D12_RESOURCE_STATES initState_;
+
+    SizeClassAllocator allocator_;
+
+    std::vector<BlockRsc> blocks_;
+
+    std::map<ID3D12Resource *, ComPtr<ID3D12Resource>> dedicatedRscs_;
+
+    AllocationCounter counter_;
+};
+
+AGZ_D3D12_END
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <agz/d3d12/common.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief size-class free lists over fixed-size blocks
+ *
+ * contains only bookkeeping (no d3d12 object), so it can be tested without
+ *  a device. size classes are powers of two in [minClassSize, maxClassSize].
+ *  each block is carved into slots of a single class when first needed and
+ *  returned to the empty-block list when all its slots are freed, so one block
+ *  can serve different classes over time.
+ *
+ * offset of every slot is a multiple of its class size.
+ */
+class SizeClassAllocator
+{
+public:
+
+    struct Allocation
+    {
+        uint32_t block     = 0;
+        uint32_t sizeClass = 0;
+        uint64_t offset    = 0;
+        uint64_t size      = 0;
+    };
+
+    /**
+     * @param blockSize must be a multiple of maxClassSize
+     * @param minClassSize power of two
+     * @param maxClassSize power of two and >= minClassSize
+     */
+    SizeClassAllocator(
+        uint64_t blockSize,
+        uint64_t minClassSize,
+        uint64_t maxClassSize);
+
+    /**
+     * @brief can a request of 'size' bytes be served by size classes
+     */
+    bool isSuballocatable(uint64_t size) const noexcept;
+
+    /**
+     * @brief allocate a slot for 'size' bytes
+     *
+     * returns nullopt when there is no free slot of the required class and no
+     *  empty block. call addBlock and retry in that case.
+     *
+     * size must satisfy isSuballocatable
+     */
+    std::optional<Allocation> alloc(uint64_t size);
+
+    void free(const Allocation &allocation);
+
+    /**
+     * @brief register a new empty block and return its index
+     */
+    uint32_t addBlock();
+
+    uint32_t getClassIndex(uint64_t size) const noexcept;
+
+    uint64_t getClassSize(uint32_t classIdx) const noexcept;
+
+    uint64_t getBlockSize() const noexcept;
+
+    uint32_t getBlockCount() const noexcept;
+
+    uint32_t getEmptyBlockCount() const noexcept;
+
+    /**
+     * @brief number of live slots in given block
+     */
+    uint32_t getLiveCount(uint32_t block) const noexcept;
+
+private:
+
+    static constexpr uint32_t NO_CLASS = UINT32_MAX;
+
+    struct Block
+    {
+        uint32_t sizeClass = NO_CLASS;
+        uint32_t liveCount = 0;
+        std::vector<uint32_t> freeSlots;
+    };
+
+    void removePartialBlock(uint32_t classIdx, uint32_t block);
+
+    uint64_t blockSize_;
+    uint64_t minClassSize_;
+    uint32_t classCount_;
+
+    std::vector<Block> blocks_;
+
+    // blocks of each class having at least one free slot
+    std::vector<std::vector<uint32_t>> partialBlocks_;
+
+    std::vector<uint32_t> emptyBlocks_;
+};
+
+inline SizeClassAllocator::SizeClassAllocator(
+    uint64_t blockSize,
+    uint64_t minClassSize,
+    uint64_t maxClassSize)
+    : blockSize_(blockSize), minClassSize_(minClassSize), classCount_(0)
+{
+    assert(minClassSize && !(minClassSize & (minClassSize - 1)));
+    assert(maxClassSize >= minClassSize && !(maxClassSize & (maxClassSize - 1)));
+    assert(blockSize % maxClassSize == 0);
+
+    for(uint64_t s = minClassSize; s <= maxClassSize; s <<= 1)
+        ++classCount_;
+
+    partialBlocks_.resize(classCount_);
+}
+
+inline bool SizeClassAllocator::isSuballocatable(uint64_t size) const noexcept
+{
+    return size <= getClassSize(classCount_ - 1);
+}
+
+inline std::optional<SizeClassAllocator::Allocation>
+    SizeClassAllocator::alloc(uint64_t size)
+{
+    assert(isSuballocatable(size));
+
+    const uint32_t classIdx  = getClassIndex(size);
+    const uint64_t classSize = getClassSize(classIdx);
+    auto &partials = partialBlocks_[classIdx];
+
+    if(partials.empty())
+    {
+        if(emptyBlocks_.empty())
+            return std::nullopt;
+
+        const uint32_t blockIdx = emptyBlocks_.back();
+        emptyBlocks_.pop_back();
+
+        // carve the empty block into slots of this class. slots are pushed in
+        // reverse order so that low offsets are handed out first
+
+        auto &block = blocks_[blockIdx];
+        block.sizeClass = classIdx;
+
+        const uint32_t slotCount = static_cast<uint32_t>(blockSize_ / classSize);
+        block.freeSlots.resize(slotCount);
+        for(uint32_t i = 0; i < slotCount; ++i)
+            block.freeSlots[i] = slotCount - 1 - i;
+
+        partials.push_back(blockIdx);
+    }
+
+    const uint32_t blockIdx = partials.back();
+    auto &block = blocks_[blockIdx];
+
+    const uint32_t slot = block.freeSlots.back();
+    block.freeSlots.pop_back();
+    ++block.liveCount;
+
+    if(block.freeSlots.empty())
+        partials.pop_back();
+
+    Allocation ret;
+    ret.block     = blockIdx;
+    ret.sizeClass = classIdx;
+    ret.offset    = slot * classSize;
+    ret.size      = classSize;
+    return ret;
+}
+
+inline void SizeClassAllocator::free(const Allocation &allocation)
+{
+    auto &block = blocks_[allocation.block];
+    assert(block.sizeClass == allocation.sizeClass && block.liveCount);
+
+    const uint32_t slot = static_cast<uint32_t>(
+        allocation.offset / getClassSize(allocation.sizeClass));
+
+    if(block.freeSlots.empty())
+        partialBlocks_[block.sizeClass].push_back(allocation.block);
+    block.freeSlots.push_back(slot);
+
+    if(--block.liveCount)
+        return;
+
+    // the whole block is free. give it back to the empty list
+
+    removePartialBlock(block.sizeClass, allocation.block);
+
+    block.sizeClass = NO_CLASS;
+    block.freeSlots.clear();
+    block.freeSlots.shrink_to_fit();
+
+    emptyBlocks_.push_back(allocation.block);
+}
+
+inline uint32_t SizeClassAllocator::addBlock()
+{
+    const uint32_t ret = static_cast<uint32_t>(blocks_.size());
+    blocks_.emplace_back();
+    emptyBlocks_.push_back(ret);
+    return ret;
+}
+
+inline uint32_t SizeClassAllocator::getClassIndex(uint64_t size) const noexcept
+{
+    uint32_t ret = 0;
+    while(getClassSize(ret) < size)
+        ++ret;
+    return ret;
+}
+
+inline uint64_t SizeClassAllocator::getClassSize(uint32_t classIdx) const noexcept
+{
+    return minClassSize_ << classIdx;
+}
+
+inline uint64_t SizeClassAllocator::getBlockSize() const noexcept
+{
+    return blockSize_;
+}
+
+inline uint32_t SizeClassAllocator::getBlockCount() const noexcept
+{
+    return static_cast<uint32_t>(blocks_.size());
+}
+
+inline uint32_t SizeClassAllocator::getEmptyBlockCount() const noexcept
+{
+    return static_cast<uint32_t>(emptyBlocks_.size());
+}
+
+inline uint32_t SizeClassAllocator::getLiveCount(uint32_t block) const noexcept
+{
+    return blocks_[block].liveCount;
+}
+
+inline void SizeClassAllocator::removePartialBlock(
+    uint32_t classIdx, uint32_t block)
+{
+    auto &partials = partialBlocks_[classIdx];
+    for(size_t i = 0; i < partials.size(); ++i)
+    {
+        if(partials[i] == block)
+        {
+            partials[i] = partials.back();
+            partials.pop_back();
+            return;
+        }
+    }
+}
+
+AGZ_D3D12_END
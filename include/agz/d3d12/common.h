@@ -10,8 +10,7 @@
 
 #include <wrl/client.h>
 
-#define AGZ_D3D12_BEGIN namespace agz::d3d12 {
-#define AGZ_D3D12_END   }
+#include <agz/d3d12/base.h>
 
 AGZ_D3D12_BEGIN
 
@@ -27,13 +26,6 @@ using Trans4 = Mat4::right_transform;
 
 using Microsoft::WRL::ComPtr;
 
-class D3D12LabException : public std::runtime_error
-{
-public:
-
-    using runtime_error::runtime_error;
-};
-
 inline D3D12_CLEAR_VALUE CreateClearColorValue(
     DXGI_FORMAT format, float r, float g, float b, float a) noexcept
 {
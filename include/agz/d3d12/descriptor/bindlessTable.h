@@ -0,0 +1,142 @@
+#pragma once
+
+#include <agz/d3d12/descriptor/singleDescriptorPool.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief shader-visible descriptor table whose entries have stable indices
+ *
+ * the table is bound once by a descriptor table with an unbounded range
+ *  (see fg::UNBOUNDED_RANGE). shaders read indices of their descriptors from
+ *  constants, so no descriptor table needs to be set per draw.
+ *
+ * a freed index may be reused by the next allocation, so it must not be
+ *  freed until gpu finishes using it.
+ *
+ * NOT thread-safe.
+ */
+class BindlessTable : public misc::uncopyable_t
+{
+    SingleDescriptorPool pool_;
+
+public:
+
+    using Index = UINT;
+
+    BindlessTable() = default;
+
+    BindlessTable(BindlessTable &&other) noexcept;
+
+    BindlessTable &operator=(BindlessTable &&other) noexcept;
+
+    void swap(BindlessTable &other) noexcept;
+
+    /**
+     * @brief manage all descriptors in a range of shader-visible heap
+     */
+    void initialize(const DescriptorRange &range);
+
+    bool isAvailable() const noexcept;
+
+    void destroy();
+
+    Index alloc();
+
+    std::optional<Index> tryAlloc();
+
+    void free(Index index);
+
+    /**
+     * @brief descriptor at index, for creating its view
+     */
+    Descriptor operator[](Index index) const noexcept;
+
+    /**
+     * @brief start of the table, for SetXXXRootDescriptorTable
+     */
+    D3D12_GPU_DESCRIPTOR_HANDLE getGPUHandle() const noexcept;
+
+    DescriptorCount getCapacity() const noexcept;
+
+    DescriptorCount getFreeCount() const noexcept;
+};
+
+inline BindlessTable::BindlessTable(BindlessTable &&other) noexcept
+{
+    swap(other);
+}
+
+inline BindlessTable &BindlessTable::operator=(BindlessTable &&other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+inline void BindlessTable::swap(BindlessTable &other) noexcept
+{
+    pool_.swap(other.pool_);
+}
+
+inline void BindlessTable::initialize(const DescriptorRange &range)
+{
+    pool_.initialize(range);
+}
+
+inline bool BindlessTable::isAvailable() const noexcept
+{
+    return pool_.isAvailable();
+}
+
+inline void BindlessTable::destroy()
+{
+    pool_.destroy();
+}
+
+inline BindlessTable::Index BindlessTable::alloc()
+{
+    auto ret = tryAlloc();
+    if(!ret)
+        throw D3D12LabException("bindless table: out of descriptors");
+    return *ret;
+}
+
+inline std::optional<BindlessTable::Index> BindlessTable::tryAlloc()
+{
+    const auto descriptor = pool_.tryAlloc();
+    if(!descriptor)
+        return std::nullopt;
+    return descriptor->getIndexInRawHeap() -
+           pool_.getRange().getStartIndexInRawHeap();
+}
+
+inline void BindlessTable::free(Index index)
+{
+    const auto &range = pool_.getRange();
+    const auto descriptor = range[index];
+    pool_.free(PooledDescriptor(
+        descriptor.getCPUHandle(), descriptor.getGPUHandle(),
+        range.getStartIndexInRawHeap() + index));
+}
+
+inline Descriptor BindlessTable::operator[](Index index) const noexcept
+{
+    return pool_.getRange()[index];
+}
+
+inline D3D12_GPU_DESCRIPTOR_HANDLE BindlessTable::getGPUHandle() const noexcept
+{
+    return pool_.getRange()[0].getGPUHandle();
+}
+
+inline DescriptorCount BindlessTable::getCapacity() const noexcept
+{
+    return pool_.getCapacity();
+}
+
+inline DescriptorCount BindlessTable::getFreeCount() const noexcept
+{
+    return pool_.getFreeCount();
+}
+
+AGZ_D3D12_END
@@ -0,0 +1,334 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <vector>
+
+#include <agz/d3d12/descriptor/descriptorHeap.h>
+#include <agz/d3d12/descriptor/singleDescriptorPool.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief descriptor allocator shared by multiple threads
+ *
+ * single descriptors are allocated by per-thread local caches. a cache is
+ *  refilled with a batch of descriptors from the shared free list under a short
+ *  lock, and returns a batch when it holds too many freed descriptors. the
+ *  shared free list grows by carving blocks from the sub heap.
+ *
+ * ranges are allocated from the sub heap directly under the lock.
+ */
+class ConcurrentDescriptorAllocator : public misc::uncopyable_t
+{
+public:
+
+    /**
+     * @brief per-thread descriptor cache. NOT thread-safe
+     *
+     * remaining descriptors are returned to the allocator when destroyed.
+     *  all caches must be destroyed before the allocator
+     */
+    class LocalCache : public misc::uncopyable_t
+    {
+        ConcurrentDescriptorAllocator *allocator_;
+
+        std::vector<PooledDescriptor> descriptors_;
+
+    public:
+
+        LocalCache() noexcept;
+
+        explicit LocalCache(ConcurrentDescriptorAllocator &allocator);
+
+        LocalCache(LocalCache &&other) noexcept;
+
+        LocalCache &operator=(LocalCache &&other) noexcept;
+
+        ~LocalCache();
+
+        void swap(LocalCache &other) noexcept;
+
+        PooledDescriptor alloc();
+
+        std::optional<PooledDescriptor> tryAlloc();
+
+        void free(const PooledDescriptor &descriptor);
+
+        /**
+         * @brief return all cached descriptors to the allocator
+         */
+        void flush();
+    };
+
+    /**
+     * @param subHeap   managed descriptors
+     * @param batchSize descriptors moved between local cache and allocator at
+     *                  a time
+     * @param blockSize descriptors carved from sub heap when the shared free
+     *                  list is empty. must be no less than batchSize
+     */
+    explicit ConcurrentDescriptorAllocator(
+        DescriptorSubHeap subHeap,
+        DescriptorCount   batchSize = 32,
+        DescriptorCount   blockSize = 256);
+
+    LocalCache createLocalCache();
+
+    /**
+     * @brief allocate a single descriptor without local cache
+     */
+    PooledDescriptor allocSingle();
+
+    std::optional<PooledDescriptor> tryAllocSingle();
+
+    void freeSingle(const PooledDescriptor &descriptor);
+
+    DescriptorRange allocRange(DescriptorCount count);
+
+    std::optional<DescriptorRange> tryAllocRange(DescriptorCount count);
+
+    void freeRange(const DescriptorRange &range);
+
+    ID3D12DescriptorHeap *getRawHeap() const noexcept;
+
+private:
+
+    // append at most 'count' descriptors to 'output'. returns false when no
+    // descriptor is available
+    bool acquireBatch(
+        std::vector<PooledDescriptor> &output, DescriptorCount count);
+
+    void releaseBatch(const PooledDescriptor *descriptors, size_t count);
+
+    // requires mutex_ being locked
+    bool carveBlock();
+
+    const DescriptorCount batchSize_;
+    const DescriptorCount blockSize_;
+
+    std::mutex mutex_;
+
+    DescriptorSubHeap subHeap_;
+
+    std::vector<PooledDescriptor> freeList_;
+};
+
+inline ConcurrentDescriptorAllocator::LocalCache::LocalCache() noexcept
+    : allocator_(nullptr)
+{
+
+}
+
+inline ConcurrentDescriptorAllocator::LocalCache::LocalCache(
+    ConcurrentDescriptorAllocator &allocator)
+    : allocator_(&allocator)
+{
+    descriptors_.reserve(2 * allocator.batchSize_);
+}
+
+inline ConcurrentDescriptorAllocator::LocalCache::LocalCache(
+    LocalCache &&other) noexcept
+    : LocalCache()
+{
+    swap(other);
+}
+
+inline ConcurrentDescriptorAllocator::LocalCache &
+    ConcurrentDescriptorAllocator::LocalCache::operator=(
+        LocalCache &&other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+inline ConcurrentDescriptorAllocator::LocalCache::~LocalCache()
+{
+    flush();
+}
+
+inline void ConcurrentDescriptorAllocator::LocalCache::swap(
+    LocalCache &other) noexcept
+{
+    std::swap(allocator_,   other.allocator_);
+    std::swap(descriptors_, other.descriptors_);
+}
+
+inline PooledDescriptor ConcurrentDescriptorAllocator::LocalCache::alloc()
+{
+    auto ret = tryAlloc();
+    if(!ret)
+    {
+        throw D3D12LabException(
+            "concurrent descriptor allocator: out of descriptors");
+    }
+    return *ret;
+}
+
+inline std::optional<PooledDescriptor>
+    ConcurrentDescriptorAllocator::LocalCache::tryAlloc()
+{
+    assert(allocator_);
+
+    if(descriptors_.empty() &&
+       !allocator_->acquireBatch(descriptors_, allocator_->batchSize_))
+        return std::nullopt;
+
+    const auto ret = descriptors_.back();
+    descriptors_.pop_back();
+    return ret;
+}
+
+inline void ConcurrentDescriptorAllocator::LocalCache::free(
+    const PooledDescriptor &descriptor)
+{
+    assert(allocator_);
+
+    descriptors_.push_back(descriptor);
+
+    // keep one batch for following allocations and return the other one
+
+    const DescriptorCount batchSize = allocator_->batchSize_;
+    if(descriptors_.size() >= 2 * batchSize)
+    {
+        const size_t keep = descriptors_.size() - batchSize;
+        allocator_->releaseBatch(descriptors_.data() + keep, batchSize);
+        descriptors_.resize(keep);
+    }
+}
+
+inline void ConcurrentDescriptorAllocator::LocalCache::flush()
+{
+    if(allocator_ && !descriptors_.empty())
+    {
+        allocator_->releaseBatch(descriptors_.data(), descriptors_.size());
+        descriptors_.clear();
+    }
+}
+
+inline ConcurrentDescriptorAllocator::ConcurrentDescriptorAllocator(
+    DescriptorSubHeap subHeap,
+    DescriptorCount   batchSize,
+    DescriptorCount   blockSize)
+    : batchSize_(batchSize),
+      blockSize_(blockSize),
+      subHeap_(std::move(subHeap))
+{
+    assert(batchSize_ && batchSize_ <= blockSize_);
+}
+
+inline ConcurrentDescriptorAllocator::LocalCache
+    ConcurrentDescriptorAllocator::createLocalCache()
+{
+    return LocalCache(*this);
+}
+
+inline PooledDescriptor ConcurrentDescriptorAllocator::allocSingle()
+{
+    auto ret = tryAllocSingle();
+    if(!ret)
+    {
+        throw D3D12LabException(
+            "concurrent descriptor allocator: out of descriptors");
+    }
+    return *ret;
+}
+
+inline std::optional<PooledDescriptor>
+    ConcurrentDescriptorAllocator::tryAllocSingle()
+{
+    std::lock_guard lk(mutex_);
+
+    if(freeList_.empty() && !carveBlock())
+        return std::nullopt;
+
+    const auto ret = freeList_.back();
+    freeList_.pop_back();
+    return ret;
+}
+
+inline void ConcurrentDescriptorAllocator::freeSingle(
+    const PooledDescriptor &descriptor)
+{
+    std::lock_guard lk(mutex_);
+    freeList_.push_back(descriptor);
+}
+
+inline DescriptorRange ConcurrentDescriptorAllocator::allocRange(
+    DescriptorCount count)
+{
+    auto ret = tryAllocRange(count);
+    if(!ret)
+    {
+        throw D3D12LabException(
+            "concurrent descriptor allocator: out of descriptors");
+    }
+    return *ret;
+}
+
+inline std::optional<DescriptorRange>
+    ConcurrentDescriptorAllocator::tryAllocRange(DescriptorCount count)
+{
+    std::lock_guard lk(mutex_);
+    return subHeap_.tryAllocRange(count);
+}
+
+inline void ConcurrentDescriptorAllocator::freeRange(
+    const DescriptorRange &range)
+{
+    std::lock_guard lk(mutex_);
+    subHeap_.freeRange(range);
+}
+
+inline ID3D12DescriptorHeap *
+    ConcurrentDescriptorAllocator::getRawHeap() const noexcept
+{
+    return subHeap_.getRawHeap();
+}
+
+inline bool ConcurrentDescriptorAllocator::acquireBatch(
+    std::vector<PooledDescriptor> &output, DescriptorCount count)
+{
+    std::lock_guard lk(mutex_);
+
+    if(freeList_.empty() && !carveBlock())
+        return false;
+
+    const size_t n = (std::min)(size_t(count), freeList_.size());
+    output.insert(output.end(), freeList_.end() - n, freeList_.end());
+    freeList_.resize(freeList_.size() - n);
+
+    return true;
+}
+
+inline void ConcurrentDescriptorAllocator::releaseBatch(
+    const PooledDescriptor *descriptors, size_t count)
+{
+    std::lock_guard lk(mutex_);
+    freeList_.insert(freeList_.end(), descriptors, descriptors + count);
+}
+
+inline bool ConcurrentDescriptorAllocator::carveBlock()
+{
+    // fall back to smaller blocks when the sub heap is nearly exhausted
+
+    for(DescriptorCount size = blockSize_; size; size /= 2)
+    {
+        if(auto range = subHeap_.tryAllocRange(size))
+        {
+            const DescriptorIndex start = range->getStartIndexInRawHeap();
+            for(DescriptorIndex i = 0; i < size; ++i)
+            {
+                const auto d = (*range)[i];
+                freeList_.emplace_back(
+                    d.getCPUHandle(), d.getGPUHandle(), start + i);
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+AGZ_D3D12_END
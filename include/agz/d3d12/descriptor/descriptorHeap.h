@@ -1,9 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
 #include <set>
 
+#include <agz/d3d12/descriptor/freeIntervalList.h>
 #include <agz/d3d12/descriptor/rawDescriptorHeap.h>
-#include <agz/utility/container.h>
 
 AGZ_D3D12_BEGIN
 
@@ -61,13 +63,15 @@ public:
     DescriptorIndex getStartIndexInRawHeap() const noexcept;
 };
 
+using DescriptorHeapStats = FreeIntervalList<DescriptorIndex>::Stats;
+
 class DescriptorSubHeap : public misc::uncopyable_t
 {
     friend class DescriptorHeap;
 
     RawDescriptorHeap *rawHeap_;
 
-    container::interval_mgr_t<uint32_t> freeBlocks_;
+    FreeIntervalList<DescriptorIndex> freeBlocks_;
 
     DescriptorIndex beg_;
     DescriptorIndex end_;
@@ -97,6 +101,8 @@ public:
 
     ID3D12DescriptorHeap *getRawHeap() const noexcept;
 
+    DescriptorCount getCount() const noexcept;
+
     DescriptorSubHeap allocSubHeap(
         DescriptorCount subHeapSize);
 
@@ -120,6 +126,28 @@ public:
     void freeRange(const DescriptorRange &range);
 
     void freeSingle(Descriptor descriptor);
+
+    DescriptorHeapStats getStats() const noexcept;
+
+    using RelocationCallback = std::function<
+        void(const DescriptorRange &oldRange, const DescriptorRange &newRange)>;
+
+    /**
+     * @brief move live ranges towards the start of sub heap
+     *
+     * ranges not in 'liveRanges' (including sub heaps) stay in place.
+     *  descriptors in non-shader-visible heaps are copied to new positions.
+     *  shader-visible heaps can not be copy sources, so views must be
+     *  recreated by the callback.
+     *
+     * gpu must not be accessing any of the moved ranges.
+     *
+     * returns number of moved ranges
+     */
+    size_t compact(
+        ID3D12Device                 *device,
+        std::vector<DescriptorRange>  liveRanges,
+        const RelocationCallback     &callback);
 };
 
 class DescriptorHeap : DescriptorSubHeap
@@ -141,6 +169,7 @@ public:
     void destroy();
 
     using DescriptorSubHeap::getRawHeap;
+    using DescriptorSubHeap::getCount;
 
     using DescriptorSubHeap::allocSubHeap;
     using DescriptorSubHeap::allocRange;
@@ -154,6 +183,9 @@ public:
     using DescriptorSubHeap::freeRange;
     using DescriptorSubHeap::freeSingle;
 
+    using DescriptorSubHeap::getStats;
+    using DescriptorSubHeap::compact;
+
     DescriptorSubHeap       &getRootSubheap() noexcept;
     const DescriptorSubHeap &getRootSubheap() const noexcept;
 };
@@ -238,7 +270,7 @@ inline DescriptorIndex DescriptorRange::getStartIndexInRawHeap() const noexcept
 inline void DescriptorSubHeap::destroy()
 {
     rawHeap_ = nullptr;
-    freeBlocks_ = container::interval_mgr_t<DescriptorIndex>();
+    freeBlocks_.clear();
 }
 
 inline DescriptorSubHeap::DescriptorSubHeap()
@@ -300,6 +332,11 @@ inline ID3D12DescriptorHeap *DescriptorSubHeap::getRawHeap() const noexcept
     return rawHeap_->getHeap();
 }
 
+inline DescriptorCount DescriptorSubHeap::getCount() const noexcept
+{
+    return end_ - beg_;
+}
+
 inline DescriptorSubHeap DescriptorSubHeap::allocSubHeap(
     DescriptorCount subHeapSize)
 {
@@ -374,6 +411,66 @@ inline void DescriptorSubHeap::freeSingle(Descriptor descriptor)
     freeBlocks_.free(idx, idx + 1);
 }
 
+inline DescriptorHeapStats DescriptorSubHeap::getStats() const noexcept
+{
+    return freeBlocks_.getStats();
+}
+
+inline size_t DescriptorSubHeap::compact(
+    ID3D12Device                 *device,
+    std::vector<DescriptorRange>  liveRanges,
+    const RelocationCallback     &callback)
+{
+    const auto heapDesc = rawHeap_->getHeap()->GetDesc();
+    const bool copyable =
+        !(heapDesc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE);
+
+    std::sort(
+        liveRanges.begin(), liveRanges.end(),
+        [](const DescriptorRange &a, const DescriptorRange &b)
+    {
+        return a.beg_ < b.beg_;
+    });
+
+    // each range is freed and reallocated at the lowest position that fits,
+    // which is never after its old position
+
+    size_t moveCount = 0;
+    for(auto &oldRange : liveRanges)
+    {
+        assert(oldRange.rawHeap_ == rawHeap_);
+        if(!oldRange.cnt_)
+            continue;
+
+        freeRange(oldRange);
+        const DescriptorIndex newBeg = *freeBlocks_.allocLowest(oldRange.cnt_);
+        if(newBeg == oldRange.beg_)
+            continue;
+
+        const DescriptorRange newRange(rawHeap_, newBeg, oldRange.cnt_);
+
+        if(copyable)
+        {
+            // chunks never overlap their destinations
+
+            const DescriptorCount step = oldRange.beg_ - newBeg;
+            for(DescriptorIndex i = 0; i < oldRange.cnt_; i += step)
+            {
+                device->CopyDescriptorsSimple(
+                    (std::min)(step, oldRange.cnt_ - i),
+                    newRange[i].getCPUHandle(),
+                    oldRange[i].getCPUHandle(),
+                    heapDesc.Type);
+            }
+        }
+
+        callback(oldRange, newRange);
+        ++moveCount;
+    }
+
+    return moveCount;
+}
+
 inline DescriptorHeap::DescriptorHeap()
 {
     
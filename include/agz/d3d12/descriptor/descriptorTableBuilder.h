@@ -0,0 +1,157 @@
+#pragma once
+
+#include <vector>
+
+#include <agz/d3d12/descriptor/transientDescriptorRing.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief assemble a contiguous descriptor table from descriptors in
+ *  non-shader-visible staging heaps
+ *
+ * views are created once in staging heaps. each table is built by copying
+ *  them into a shader-visible range with one CopyDescriptors call, where
+ *  contiguous source descriptors are coalesced into a single source range.
+ *
+ * NOT thread-safe.
+ */
+class DescriptorTableBuilder
+{
+    D3D12_DESCRIPTOR_HEAP_TYPE type_;
+    UINT descIncSize_;
+
+    // coalesced source ranges
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> srcStarts_;
+    std::vector<UINT>                        srcSizes_;
+
+    UINT count_;
+
+public:
+
+    DescriptorTableBuilder(
+        ID3D12Device *device, D3D12_DESCRIPTOR_HEAP_TYPE type);
+
+    void clear() noexcept;
+
+    /**
+     * @brief append a descriptor from a non-shader-visible heap
+     */
+    DescriptorTableBuilder &add(D3D12_CPU_DESCRIPTOR_HANDLE src);
+
+    /**
+     * @brief append all descriptors in a range of a non-shader-visible heap
+     */
+    DescriptorTableBuilder &add(const DescriptorRange &src);
+
+    UINT getCount() const noexcept;
+
+    /**
+     * @brief number of source ranges after coalescing
+     */
+    UINT getSourceRangeCount() const noexcept;
+
+    /**
+     * @brief copy appended descriptors to [dst, dst + getCount())
+     */
+    void copyTo(ID3D12Device *device, D3D12_CPU_DESCRIPTOR_HANDLE dst) const;
+
+    /**
+     * @brief copy appended descriptors to a range allocated from ring
+     */
+    DescriptorRange build(
+        ID3D12Device *device, TransientDescriptorRing &ring) const;
+};
+
+inline DescriptorTableBuilder::DescriptorTableBuilder(
+    ID3D12Device *device, D3D12_DESCRIPTOR_HEAP_TYPE type)
+    : type_(type),
+      descIncSize_(device->GetDescriptorHandleIncrementSize(type)),
+      count_(0)
+{
+
+}
+
+inline void DescriptorTableBuilder::clear() noexcept
+{
+    srcStarts_.clear();
+    srcSizes_.clear();
+    count_ = 0;
+}
+
+inline DescriptorTableBuilder &DescriptorTableBuilder::add(
+    D3D12_CPU_DESCRIPTOR_HANDLE src)
+{
+    if(!srcStarts_.empty() &&
+       srcStarts_.back().ptr + SIZE_T(srcSizes_.back()) * descIncSize_ == src.ptr)
+        ++srcSizes_.back();
+    else
+    {
+        srcStarts_.push_back(src);
+        srcSizes_.push_back(1);
+    }
+
+    ++count_;
+    return *this;
+}
+
+inline DescriptorTableBuilder &DescriptorTableBuilder::add(
+    const DescriptorRange &src)
+{
+    if(!src.getCount())
+        return *this;
+
+    const D3D12_CPU_DESCRIPTOR_HANDLE start = src[0].getCPUHandle();
+    if(!srcStarts_.empty() &&
+       srcStarts_.back().ptr + SIZE_T(srcSizes_.back()) * descIncSize_ == start.ptr)
+        srcSizes_.back() += src.getCount();
+    else
+    {
+        srcStarts_.push_back(start);
+        srcSizes_.push_back(src.getCount());
+    }
+
+    count_ += src.getCount();
+    return *this;
+}
+
+inline UINT DescriptorTableBuilder::getCount() const noexcept
+{
+    return count_;
+}
+
+inline UINT DescriptorTableBuilder::getSourceRangeCount() const noexcept
+{
+    return static_cast<UINT>(srcStarts_.size());
+}
+
+inline void DescriptorTableBuilder::copyTo(
+    ID3D12Device *device, D3D12_CPU_DESCRIPTOR_HANDLE dst) const
+{
+    if(!count_)
+        return;
+
+    if(srcStarts_.size() == 1)
+    {
+        device->CopyDescriptorsSimple(count_, dst, srcStarts_[0], type_);
+        return;
+    }
+
+    device->CopyDescriptors(
+        1, &dst, &count_,
+        static_cast<UINT>(srcStarts_.size()),
+        srcStarts_.data(), srcSizes_.data(), type_);
+}
+
+inline DescriptorRange DescriptorTableBuilder::build(
+    ID3D12Device *device, TransientDescriptorRing &ring) const
+{
+    if(!count_)
+        return {};
+
+    auto ret = ring.allocRange(count_);
+    copyTo(device, ret[0].getCPUHandle());
+    return ret;
+}
+
+AGZ_D3D12_END
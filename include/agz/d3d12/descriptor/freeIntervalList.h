@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cassert>
+#include <map>
+#include <optional>
+#include <set>
+
+#include <agz/d3d12/common.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief free intervals of an index space, with fragmentation stats
+ *
+ * contains no d3d12 object. allocation is best-fit. adjacent free intervals
+ *  are always merged.
+ */
+template<typename T>
+class FreeIntervalList
+{
+public:
+
+    struct Stats
+    {
+        T freeCount        = 0;
+        T largestFreeBlock = 0;
+        T freeBlockCount   = 0;
+
+        /**
+         * @brief 0 when all free space is in one block
+         */
+        float getFragmentation() const noexcept;
+    };
+
+    void clear() noexcept;
+
+    void swap(FreeIntervalList &other) noexcept;
+
+    /**
+     * @brief returns beg of allocated interval
+     */
+    std::optional<T> alloc(T count);
+
+    /**
+     * @brief allocate the free interval with lowest address that fits
+     */
+    std::optional<T> allocLowest(T count);
+
+    /**
+     * @brief free [beg, end). the interval must not overlap free ones
+     */
+    void free(T beg, T end);
+
+    Stats getStats() const noexcept;
+
+private:
+
+    void insert(T beg, T end);
+
+    void erase(typename std::map<T, T>::iterator it);
+
+    // beg -> end
+    std::map<T, T> byBeg_;
+
+    // (size, beg)
+    std::set<std::pair<T, T>> bySize_;
+
+    T freeCount_ = 0;
+};
+
+template<typename T>
+float FreeIntervalList<T>::Stats::getFragmentation() const noexcept
+{
+    if(!freeCount)
+        return 0;
+    return 1 - static_cast<float>(largestFreeBlock) / freeCount;
+}
+
+template<typename T>
+void FreeIntervalList<T>::clear() noexcept
+{
+    byBeg_.clear();
+    bySize_.clear();
+    freeCount_ = 0;
+}
+
+template<typename T>
+void FreeIntervalList<T>::swap(FreeIntervalList &other) noexcept
+{
+    byBeg_.swap(other.byBeg_);
+    bySize_.swap(other.bySize_);
+    std::swap(freeCount_, other.freeCount_);
+}
+
+template<typename T>
+std::optional<T> FreeIntervalList<T>::alloc(T count)
+{
+    const auto sit = bySize_.lower_bound({ count, T(0) });
+    if(sit == bySize_.end())
+        return std::nullopt;
+
+    const T beg = sit->second;
+    const T end = beg + sit->first;
+
+    erase(byBeg_.find(beg));
+    if(beg + count < end)
+        insert(beg + count, end);
+
+    freeCount_ -= count;
+    return beg;
+}
+
+template<typename T>
+std::optional<T> FreeIntervalList<T>::allocLowest(T count)
+{
+    for(auto it = byBeg_.begin(); it != byBeg_.end(); ++it)
+    {
+        const T beg = it->first;
+        const T end = it->second;
+        if(end - beg < count)
+            continue;
+
+        erase(it);
+        if(beg + count < end)
+            insert(beg + count, end);
+
+        freeCount_ -= count;
+        return beg;
+    }
+    return std::nullopt;
+}
+
+template<typename T>
+void FreeIntervalList<T>::free(T beg, T end)
+{
+    if(beg >= end)
+        return;
+
+    freeCount_ += end - beg;
+
+    // merge with successor
+
+    auto next = byBeg_.lower_bound(beg);
+    assert(next == byBeg_.end() || next->first >= end);
+    if(next != byBeg_.end() && next->first == end)
+    {
+        end = next->second;
+        erase(next);
+    }
+
+    // merge with predecessor
+
+    auto it = byBeg_.lower_bound(beg);
+    if(it != byBeg_.begin())
+    {
+        auto prev = std::prev(it);
+        assert(prev->second <= beg);
+        if(prev->second == beg)
+        {
+            beg = prev->first;
+            erase(prev);
+        }
+    }
+
+    insert(beg, end);
+}
+
+template<typename T>
+typename FreeIntervalList<T>::Stats
+    FreeIntervalList<T>::getStats() const noexcept
+{
+    Stats ret;
+    ret.freeCount        = freeCount_;
+    ret.largestFreeBlock = bySize_.empty() ? T(0) : bySize_.rbegin()->first;
+    ret.freeBlockCount   = static_cast<T>(byBeg_.size());
+    return ret;
+}
+
+template<typename T>
+void FreeIntervalList<T>::insert(T beg, T end)
+{
+    byBeg_.insert({ beg, end });
+    bySize_.insert({ end - beg, beg });
+}
+
+template<typename T>
+void FreeIntervalList<T>::erase(typename std::map<T, T>::iterator it)
+{
+    bySize_.erase({ it->second - it->first, it->first });
+    byBeg_.erase(it);
+}
+
+AGZ_D3D12_END
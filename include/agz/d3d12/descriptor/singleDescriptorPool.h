@@ -0,0 +1,200 @@
+#pragma once
+
+#include <vector>
+
+#include <agz/d3d12/descriptor/descriptorHeap.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief single descriptor carrying its index in raw heap
+ *
+ * freeing it needs no handle-to-index division
+ */
+class PooledDescriptor : public Descriptor
+{
+    DescriptorIndex idx_;
+
+public:
+
+    PooledDescriptor() noexcept;
+
+    PooledDescriptor(
+        D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle,
+        D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle,
+        DescriptorIndex             idxInRawHeap) noexcept;
+
+    DescriptorIndex getIndexInRawHeap() const noexcept;
+};
+
+/**
+ * @brief O(1) allocator of single descriptors in a descriptor range
+ *
+ * free slots are linked by index. links can not live in descriptor memory
+ *  (it is write-only, and may be shader-visible), so they are kept in an
+ *  array parallel to the range.
+ *
+ * NOT thread-safe.
+ */
+class SingleDescriptorPool : public misc::uncopyable_t
+{
+    static constexpr DescriptorIndex NIL = DescriptorIndex(-1);
+
+    DescriptorRange range_;
+
+    // next_[i]: next free slot after slot i
+    std::vector<DescriptorIndex> next_;
+
+    DescriptorIndex freeHead_;
+    DescriptorCount freeCount_;
+
+public:
+
+    SingleDescriptorPool();
+
+    SingleDescriptorPool(SingleDescriptorPool &&other) noexcept;
+
+    SingleDescriptorPool &operator=(SingleDescriptorPool &&other) noexcept;
+
+    void swap(SingleDescriptorPool &other) noexcept;
+
+    /**
+     * @brief manage all descriptors in range
+     */
+    void initialize(const DescriptorRange &range);
+
+    bool isAvailable() const noexcept;
+
+    void destroy();
+
+    PooledDescriptor alloc();
+
+    std::optional<PooledDescriptor> tryAlloc();
+
+    void free(const PooledDescriptor &descriptor);
+
+    DescriptorCount getCapacity() const noexcept;
+
+    DescriptorCount getFreeCount() const noexcept;
+
+    const DescriptorRange &getRange() const noexcept;
+};
+
+inline PooledDescriptor::PooledDescriptor() noexcept
+    : idx_(0)
+{
+
+}
+
+inline PooledDescriptor::PooledDescriptor(
+    D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle,
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle,
+    DescriptorIndex             idxInRawHeap) noexcept
+    : Descriptor(cpuHandle, gpuHandle), idx_(idxInRawHeap)
+{
+
+}
+
+inline DescriptorIndex PooledDescriptor::getIndexInRawHeap() const noexcept
+{
+    return idx_;
+}
+
+inline SingleDescriptorPool::SingleDescriptorPool()
+    : freeHead_(NIL), freeCount_(0)
+{
+
+}
+
+inline SingleDescriptorPool::SingleDescriptorPool(
+    SingleDescriptorPool &&other) noexcept
+    : SingleDescriptorPool()
+{
+    swap(other);
+}
+
+inline SingleDescriptorPool &SingleDescriptorPool::operator=(
+    SingleDescriptorPool &&other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+inline void SingleDescriptorPool::swap(SingleDescriptorPool &other) noexcept
+{
+    std::swap(range_,     other.range_);
+    std::swap(next_,      other.next_);
+    std::swap(freeHead_,  other.freeHead_);
+    std::swap(freeCount_, other.freeCount_);
+}
+
+inline void SingleDescriptorPool::initialize(const DescriptorRange &range)
+{
+    const DescriptorCount count = range.getCount();
+
+    range_ = range;
+    next_.resize(count);
+    for(DescriptorIndex i = 0; i < count; ++i)
+        next_[i] = i + 1 < count ? i + 1 : NIL;
+
+    freeHead_  = count ? 0 : NIL;
+    freeCount_ = count;
+}
+
+inline bool SingleDescriptorPool::isAvailable() const noexcept
+{
+    return !next_.empty();
+}
+
+inline void SingleDescriptorPool::destroy()
+{
+    SingleDescriptorPool().swap(*this);
+}
+
+inline PooledDescriptor SingleDescriptorPool::alloc()
+{
+    return *tryAlloc();
+}
+
+inline std::optional<PooledDescriptor> SingleDescriptorPool::tryAlloc()
+{
+    if(freeHead_ == NIL)
+        return std::nullopt;
+
+    const DescriptorIndex slot = freeHead_;
+    freeHead_ = next_[slot];
+    --freeCount_;
+
+    const auto descriptor = range_[slot];
+    return std::make_optional<PooledDescriptor>(
+        descriptor.getCPUHandle(), descriptor.getGPUHandle(),
+        range_.getStartIndexInRawHeap() + slot);
+}
+
+inline void SingleDescriptorPool::free(const PooledDescriptor &descriptor)
+{
+    const DescriptorIndex slot =
+        descriptor.getIndexInRawHeap() - range_.getStartIndexInRawHeap();
+    assert(slot < next_.size());
+
+    next_[slot] = freeHead_;
+    freeHead_   = slot;
+    ++freeCount_;
+}
+
+inline DescriptorCount SingleDescriptorPool::getCapacity() const noexcept
+{
+    return static_cast<DescriptorCount>(next_.size());
+}
+
+inline DescriptorCount SingleDescriptorPool::getFreeCount() const noexcept
+{
+    return freeCount_;
+}
+
+inline const DescriptorRange &SingleDescriptorPool::getRange() const noexcept
+{
+    return range_;
+}
+
+AGZ_D3D12_END
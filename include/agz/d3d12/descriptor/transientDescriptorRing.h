@@ -0,0 +1,125 @@
+#pragma once
+
+#include <agz/d3d12/descriptor/descriptorHeap.h>
+#include <agz/d3d12/sync/fencedRingAllocator.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief per-frame linear allocator of transient descriptor ranges
+ *
+ * allocating is a bump of the ring head. all ranges allocated in a frame are
+ *  retired together by a single fence value signaled in 'endFrame'.
+ *
+ * when the ring is full, allocation waits for the oldest in-flight frame.
+ *
+ * NOT thread-safe.
+ */
+class TransientDescriptorRing : public misc::uncopyable_t
+{
+    DescriptorRange range_;
+
+    FencedRingAllocator ring_;
+
+    ComPtr<ID3D12Fence> fence_;
+    UINT64 nextFenceValue_;
+
+public:
+
+    TransientDescriptorRing();
+
+    void initialize(ID3D12Device *device, const DescriptorRange &range);
+
+    bool isAvailable() const noexcept;
+
+    /**
+     * @brief retire ranges of completed frames
+     */
+    void startFrame();
+
+    /**
+     * @brief signal the fence retiring ranges allocated in this frame
+     */
+    void endFrame(ID3D12CommandQueue *cmdQueue);
+
+    /**
+     * @brief allocate contiguous descriptors valid until this frame retires
+     *
+     * throws when count exceeds the ring capacity
+     */
+    DescriptorRange allocRange(DescriptorCount count);
+
+    std::optional<DescriptorRange> tryAllocRange(DescriptorCount count);
+
+    DescriptorCount getCapacity() const noexcept;
+};
+
+inline TransientDescriptorRing::TransientDescriptorRing()
+    : nextFenceValue_(1)
+{
+
+}
+
+inline void TransientDescriptorRing::initialize(
+    ID3D12Device *device, const DescriptorRange &range)
+{
+    AGZ_D3D12_CHECK_HR(
+        device->CreateFence(
+            0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(fence_.GetAddressOf())));
+
+    range_          = range;
+    nextFenceValue_ = 1;
+    ring_.initialize(range.getCount());
+}
+
+inline bool TransientDescriptorRing::isAvailable() const noexcept
+{
+    return fence_ != nullptr;
+}
+
+inline void TransientDescriptorRing::startFrame()
+{
+    ring_.retire(fence_->GetCompletedValue());
+}
+
+inline void TransientDescriptorRing::endFrame(ID3D12CommandQueue *cmdQueue)
+{
+    ring_.endFrame(nextFenceValue_);
+    cmdQueue->Signal(fence_.Get(), nextFenceValue_++);
+}
+
+inline DescriptorRange TransientDescriptorRing::allocRange(
+    DescriptorCount count)
+{
+    for(;;)
+    {
+        if(auto ret = tryAllocRange(count))
+            return *ret;
+
+        const auto oldest = ring_.getOldestFenceValue();
+        if(!oldest)
+        {
+            throw D3D12LabException(
+                "transient descriptor ring: capacity exceeded in one frame");
+        }
+
+        fence_->SetEventOnCompletion(*oldest, nullptr);
+        ring_.retire(*oldest);
+    }
+}
+
+inline std::optional<DescriptorRange> TransientDescriptorRing::tryAllocRange(
+    DescriptorCount count)
+{
+    const auto offset = ring_.alloc(count);
+    if(!offset)
+        return std::nullopt;
+    return range_.getSubRange(static_cast<DescriptorIndex>(*offset), count);
+}
+
+inline DescriptorCount TransientDescriptorRing::getCapacity() const noexcept
+{
+    return range_.getCount();
+}
+
+AGZ_D3D12_END
@@ -49,6 +49,15 @@ struct DepthStencilBinding
     ClearDepthStencil clearDepthStencilValue;
 };
 
+/**
+ * mark a graphics pass as fully overwriting all its render targets
+ * (e.g. fullscreen pass without blending), so that clearing them in this pass
+ * or in the previous pass using them is redundant
+ */
+struct _internalFullscreenPass { };
+
+constexpr _internalFullscreenPass FULLSCREEN_PASS = {};
+
 AGZ_D3D12_FG_END
 
 #include "./impl/resourceBinding.inl"
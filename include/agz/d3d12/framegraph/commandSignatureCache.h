@@ -0,0 +1,68 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <d3d12.h>
+
+#include <agz/d3d12/framegraph/common.h>
+
+AGZ_D3D12_FG_BEGIN
+
+/**
+ * @brief cache of command signatures used by ExecuteIndirect
+ *
+ * all methods are thread-safe, so they can be called in pass funcs
+ */
+class CommandSignatureCache : public misc::uncopyable_t
+{
+public:
+
+    explicit CommandSignatureCache(ID3D12Device *device);
+
+    ID3D12CommandSignature *getDispatchSignature(
+        UINT byteStride = sizeof(D3D12_DISPATCH_ARGUMENTS));
+
+    ID3D12CommandSignature *getDrawSignature(
+        UINT byteStride = sizeof(D3D12_DRAW_ARGUMENTS));
+
+    ID3D12CommandSignature *getDrawIndexedSignature(
+        UINT byteStride = sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+
+    /**
+     * @brief get signature for arbitrary argument layout
+     *
+     * root signature is required only when the arguments change root
+     * parameters. it is kept alive by the cache until 'clear'. argument descs
+     * are compared bytewise, so unused fields should be zero-initialized
+     */
+    ID3D12CommandSignature *getSignature(
+        const D3D12_INDIRECT_ARGUMENT_DESC *args,
+        UINT                                argCount,
+        UINT                                byteStride,
+        ID3D12RootSignature                *rootSignature = nullptr);
+
+    void clear();
+
+private:
+
+    struct Key
+    {
+        std::vector<D3D12_INDIRECT_ARGUMENT_DESC> args;
+        UINT byteStride = 0;
+
+        // held so that its address is not reused by another root signature
+        // while the entry exists
+        ComPtr<ID3D12RootSignature> rootSignature;
+
+        bool operator<(const Key &rhs) const noexcept;
+    };
+
+    ComPtr<ID3D12Device> device_;
+
+    std::mutex mutex_;
+    std::map<Key, ComPtr<ID3D12CommandSignature>> signatures_;
+};
+
+AGZ_D3D12_FG_END
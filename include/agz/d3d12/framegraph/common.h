@@ -1,6 +1,7 @@
 #pragma once
 
 #include <agz/d3d12/common.h>
+#include <agz/d3d12/texture/formatInfo.h>
 
 #define AGZ_D3D12_FG_BEGIN namespace agz::d3d12::fg {
 #define AGZ_D3D12_FG_END   }
@@ -91,44 +92,4 @@ void InvokeAll(F0 &&f0, F1 &&f1, Fs &&...fs)
     InvokeAll(std::forward<F1>(f1), std::forward<Fs>(fs)...);
 }
 
-// IMPROVE: use LUT
-inline bool isTypeless(DXGI_FORMAT format) noexcept
-{
-    static const DXGI_FORMAT TYPELESS_FMTS[] =
-    {
-        DXGI_FORMAT_R32G32B32A32_TYPELESS,
-        DXGI_FORMAT_R32G32B32_TYPELESS,
-        DXGI_FORMAT_R16G16B16A16_TYPELESS,
-        DXGI_FORMAT_R32G32_TYPELESS,
-        DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS,
-        DXGI_FORMAT_R10G10B10A2_TYPELESS,
-        DXGI_FORMAT_R8G8B8A8_TYPELESS,
-        DXGI_FORMAT_R16G16_TYPELESS,
-        DXGI_FORMAT_R32_TYPELESS,
-        DXGI_FORMAT_R24G8_TYPELESS,
-        DXGI_FORMAT_R24_UNORM_X8_TYPELESS,
-        DXGI_FORMAT_X24_TYPELESS_G8_UINT,
-        DXGI_FORMAT_R8G8_TYPELESS,
-        DXGI_FORMAT_R16_TYPELESS,
-        DXGI_FORMAT_R8_TYPELESS,
-        DXGI_FORMAT_BC1_TYPELESS,
-        DXGI_FORMAT_BC2_TYPELESS,
-        DXGI_FORMAT_BC3_TYPELESS,
-        DXGI_FORMAT_BC4_TYPELESS,
-        DXGI_FORMAT_BC5_TYPELESS,
-        DXGI_FORMAT_B8G8R8A8_TYPELESS,
-        DXGI_FORMAT_B8G8R8X8_TYPELESS,
-        DXGI_FORMAT_BC6H_TYPELESS,
-        DXGI_FORMAT_BC7_TYPELESS
-    };
-
-    for(auto f : TYPELESS_FMTS)
-    {
-        if(f == format)
-            return true;
-    }
-
-    return false;
-}
-
 AGZ_D3D12_FG_END
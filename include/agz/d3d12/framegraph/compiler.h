@@ -2,7 +2,9 @@
 
 #include <d3d12.h>
 
+#include <agz/d3d12/framegraph/copySource.h>
 #include <agz/d3d12/framegraph/graphData.h>
+#include <agz/d3d12/framegraph/indirectArgs.h>
 #include <agz/d3d12/framegraph/resourceDesc.h>
 #include <agz/d3d12/framegraph/resourceAllocator.h>
 #include <agz/d3d12/framegraph/resourceReleaser.h>
@@ -67,6 +69,9 @@ public:
 
         bool isGraphics;
 
+        // all render targets are fully overwritten by this pass
+        bool isFullscreen = false;
+
         FrameGraphPassFunc passFunc;
 
         std::vector<RscInPass> rscs;
@@ -116,7 +121,14 @@ private:
 
     struct TempRscNode
     {
-        std::vector<std::pair<PassIndex, D3D12_RESOURCE_STATES>> users;
+        struct User
+        {
+            PassIndex             pass;
+            D3D12_RESOURCE_STATES state     = {};
+            UAVAccess             uavAccess = ReadWriteUAV;
+        };
+
+        std::vector<User> users;
     };
 
     struct RscUsageInfo
@@ -132,11 +144,26 @@ private:
         D3D12_RESOURCE_STATES beforeState;
         D3D12_RESOURCE_STATES inState;
         D3D12_RESOURCE_STATES afterState;
+
+        bool uavBarrierBefore;
+        bool uavBarrierAfter;
     };
 
     void inferRscCreationFlagAndClearValue(
         CompilerPassNode::RscInPass &rscUsage);
 
+    // a clear is redundant when the pass fully overwrites the target, or when
+    // what the pass writes into the target is never observed: the next user
+    // fully overwrites it, or it is an internal rsc discarded after the pass
+    void eliminateRedundantClear(
+        const CompilerPassNode         &pass,
+        CompilerPassNode::RscInPass    &rscUsage,
+        const std::vector<TempRscNode> &rscTempNodes) const;
+
+    void checkFastClearValue(
+        const CompilerPassNode::RscInPass &rscUsage,
+        std::vector<std::string>          &warnings) const;
+
     RscUsageInfo collectRscUsages();
 
     FrameGraphResourceNode createD3DRscNode(
@@ -247,6 +274,33 @@ namespace detail
         passNode.rscs.push_back(rsc);
     }
 
+    inline void _initCompilerRP(
+        FrameGraphCompiler::CompilerPassNode &passNode,
+        const IndirectArgs &args)
+    {
+        FrameGraphCompiler::CompilerPassNode::RscInPass rsc;
+        rsc.idx     = args.rsc;
+        rsc.inState = D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+        passNode.rscs.push_back(rsc);
+    }
+
+    inline void _initCompilerRP(
+        FrameGraphCompiler::CompilerPassNode &passNode,
+        const CopySource &src)
+    {
+        FrameGraphCompiler::CompilerPassNode::RscInPass rsc;
+        rsc.idx     = src.rsc;
+        rsc.inState = D3D12_RESOURCE_STATE_COPY_SOURCE;
+        passNode.rscs.push_back(rsc);
+    }
+
+    inline void _initCompilerRP(
+        FrameGraphCompiler::CompilerPassNode &passNode,
+        const _internalFullscreenPass &)
+    {
+        passNode.isFullscreen = true;
+    }
+
     inline void _initCompilerRP(
         FrameGraphCompiler::CompilerPassNode &passNode,
         const _internalNoViewport &)
@@ -313,6 +367,26 @@ namespace detail
         passNode.rscs.push_back(rsc);
     }
     
+    inline void _initCompilerCP(
+        FrameGraphCompiler::CompilerPassNode &passNode,
+        const IndirectArgs &args)
+    {
+        FrameGraphCompiler::CompilerPassNode::RscInPass rsc;
+        rsc.idx     = args.rsc;
+        rsc.inState = D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+        passNode.rscs.push_back(rsc);
+    }
+
+    inline void _initCompilerCP(
+        FrameGraphCompiler::CompilerPassNode &passNode,
+        const CopySource &src)
+    {
+        FrameGraphCompiler::CompilerPassNode::RscInPass rsc;
+        rsc.idx     = src.rsc;
+        rsc.inState = D3D12_RESOURCE_STATE_COPY_SOURCE;
+        passNode.rscs.push_back(rsc);
+    }
+    
     inline void _initCompilerCP(
         FrameGraphCompiler::CompilerPassNode &passNode,
         ComPtr<ID3D12PipelineState> pipelineState)
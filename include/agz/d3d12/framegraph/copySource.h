@@ -0,0 +1,20 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include <agz/d3d12/framegraph/common.h>
+
+AGZ_D3D12_FG_BEGIN
+
+/**
+ * declare that a pass copies from the rsc, e.g. into readback memory. the rsc
+ * will be in COPY_SOURCE state during the pass
+ */
+struct CopySource
+{
+    explicit CopySource(ResourceIndex rsc) noexcept : rsc(rsc) { }
+
+    ResourceIndex rsc;
+};
+
+AGZ_D3D12_FG_END
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <set>
+
+#include <agz/d3d12/descriptor/transientDescriptorRing.h>
+#include <agz/d3d12/framegraph/commandSignatureCache.h>
 #include <agz/d3d12/framegraph/compiler.h>
 #include <agz/d3d12/framegraph/executer.h>
 #include <agz/d3d12/framegraph/graphData.h>
+#include <agz/d3d12/framegraph/resourceDefragmenter.h>
 
 AGZ_D3D12_FG_BEGIN
 
@@ -76,6 +81,42 @@ public:
 
     void execute();
 
+    CommandSignatureCache &getCommandSignatureCache() noexcept;
+
+    /**
+     * @brief track internal rscs with given residency manager, and make all
+     *  rscs referenced by the graph resident before executing it. a use point
+     *  is added on the graph queue after each execution
+     *
+     * must be called before the first graph is compiled
+     */
+    void setResidencyManager(ResidencyManager *residencyMgr);
+
+    /**
+     * @brief allocation telemetry of internal rscs
+     *
+     * the 'Upload' category is empty. use AllocationStats::addUploadCounter
+     *  to include uploader or readback rings
+     */
+    AllocationStats getAllocationStats() const;
+
+    /**
+     * @brief incrementally move internal rscs out of sparse heaps
+     *
+     * moves are started in 'startFrame'. moved internal rscs are patched
+     *  automatically. use 'getDefragmenter()->addRelocationCallback' for
+     *  other bindings
+     */
+    void enableDefragmentation(
+        ComPtr<ID3D12CommandQueue> copyQueue,
+        UINT64                     bytesPerFrame,
+        float                      maxHeapOccupancy = 0.5f);
+
+    /**
+     * @brief nullptr if defragmentation is not enabled
+     */
+    ResourceDefragmenter *getDefragmenter() noexcept;
+
 private:
 
     ID3D12Device       *device_;
@@ -87,12 +128,33 @@ private:
 
     ResourceAllocator rscAllocator_;
     ResourceReleaser  graphReleaser_;
-    ResourceReleaser  frameReleaser_;
+
+    // declared after rscAllocator_, so it is destroyed before the allocator
+    // it relocates rscs from. null until 'enableDefragmentation'
+    std::unique_ptr<ResourceDefragmenter> defragmenter_;
+
+    // per-frame descriptors of graph execution
+    TransientDescriptorRing rtvRing_;
+    TransientDescriptorRing dsvRing_;
+    TransientDescriptorRing gpuRing_;
+
+    // srvs & uavs are created once in non-shader-visible staging heap and
+    // copied to gpuRing_ every frame
+    DescriptorHeap  stagingHeap_;
+    DescriptorRange stagingGPUDescs_;
 
     FrameGraphExecuter executer_;
 
+    CommandSignatureCache cmdSigCache_;
+
+    ResidencyManager *residencyMgr_;
+
     std::unique_ptr<FrameGraphCompiler> compiler_;
     FrameGraphData graphData_;
+
+    // graphs are usually recompiled every frame. each warning is reported
+    // only once
+    std::set<std::string> reportedWarnings_;
 };
 
 template<typename ... Args>
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <agz/d3d12/descriptor/descriptorHeap.h>
 #include <agz/d3d12/framegraph/resourceView/depthStencilViewDesc.h>
 #include <agz/d3d12/framegraph/resourceView/renderTargetViewDesc.h>
@@ -31,6 +34,11 @@ public:
 
     void setExternalResource(ComPtr<ID3D12Resource> d3dRsc);
 
+    /**
+     * @brief replace internal rsc moved by ResourceDefragmenter
+     */
+    void relocateResource(ComPtr<ID3D12Resource> d3dRsc);
+
     ID3D12Resource *getD3DResource() const noexcept;
 
 private:
@@ -52,6 +60,10 @@ public:
         D3D12_RESOURCE_STATES inState      = {};
         D3D12_RESOURCE_STATES afterState   = {};
 
+        // uav barriers are emitted only for real uav hazards
+        bool uavBarrierBefore = false;
+        bool uavBarrierAfter  = false;
+
         using ViewDesc = misc::variant_t<
             std::monostate,
             _internalSRV,
@@ -63,6 +75,9 @@ public:
         DescriptorIndex descIdx = 0;
         mutable Descriptor descriptor;
 
+        // rsc of srv/uav cached in staging descriptor at descIdx
+        mutable ComPtr<ID3D12Resource> stagingRsc;
+
         // render target & depth stencil binding
 
         struct RTB
@@ -104,6 +119,15 @@ public:
         ComPtr<ID3D12PipelineState>           pipelineState,
         ComPtr<ID3D12RootSignature>           rootSignature) noexcept;
 
+    /**
+     * @brief create srvs & uavs in non-shader-visible staging descriptors,
+     *  except those whose rscs are unchanged since last call
+     */
+    void prepareStagingDescriptors(
+        ID3D12Device                              *device,
+        const std::vector<FrameGraphResourceNode> &rscNodes,
+        DescriptorRange                            allStagingDescs) const;
+
     bool execute(
         ID3D12Device                        *device,
         std::vector<FrameGraphResourceNode> &rscNodes,
@@ -145,6 +169,9 @@ struct FrameGraphData
     DescriptorIndex gpuDescCount = 0;
     DescriptorIndex rtvDescCount = 0;
     DescriptorIndex dsvDescCount = 0;
+
+    // performance warnings found by the compiler
+    std::vector<std::string> warnings;
 };
 
 AGZ_D3D12_FG_END
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include <agz/d3d12/framegraph/common.h>
+
+AGZ_D3D12_FG_BEGIN
+
+/**
+ * declare that a pass consumes the buffer as indirect argument (or count)
+ * buffer of ExecuteIndirect. the rsc will be in INDIRECT_ARGUMENT state
+ * during the pass, so its content can be computed by previous passes
+ */
+struct IndirectArgs
+{
+    explicit IndirectArgs(ResourceIndex rsc) noexcept : rsc(rsc) { }
+
+    ResourceIndex rsc;
+};
+
+AGZ_D3D12_FG_END
@@ -7,10 +7,14 @@
 #include <D3D12MemAlloc.h>
 
 #include <agz/d3d12/framegraph/common.h>
+#include <agz/d3d12/memory/allocationStats.h>
+#include <agz/d3d12/memory/residencyManager.h>
 
 AGZ_D3D12_FG_BEGIN
 
-// no method is thread-safe
+// no method is thread-safe.
+// each internal buffer is a dedicated rsc, not a BufferSuballocator range,
+// as the graph records explicit transitions of it
 class ResourceAllocator : public misc::uncopyable_t
 {
 public:
@@ -21,22 +25,121 @@ public:
         bool clear                   = false;
         D3D12_CLEAR_VALUE clearValue = {};
 
-        bool operator<(const ResourceDesc &rhs) const noexcept
-        {
-            return std::memcmp(this, &rhs, sizeof(rhs)) < 0;
-        }
+        bool operator<(const ResourceDesc &rhs) const noexcept;
     };
 
     ResourceAllocator(ID3D12Device *device, IDXGIAdapter *adaptor);
 
     ~ResourceAllocator();
 
+    /**
+     * @brief set eviction policy of the free pool
+     *
+     * freed rscs are kept in the pool for reusing. pooled rscs unused for
+     * more than 'maxUnusedTicks' ticks are destroyed, and the least recently
+     * freed ones are destroyed when total pooled bytes exceeds 'maxPoolBytes'
+     */
+    void setPoolPolicy(uint64_t maxUnusedTicks, UINT64 maxPoolBytes);
+
+    /**
+     * @brief create a new rsc, or reuse a pooled one with the same desc
+     *
+     * a reused rsc is guaranteed to be in 'expectedInitialState'
+     */
     ComPtr<ID3D12Resource> allocResource(
         const ResourceDesc    &desc,
         D3D12_RESOURCE_STATES  expectedInitialState);
 
+    /**
+     * @brief return a rsc to the pool
+     *
+     * the rsc must be no longer used by gpu, and must be in the state
+     * specified in allocating it
+     */
     void freeResource(ComPtr<ID3D12Resource> rsc);
 
+    /**
+     * @brief advance the pool age and evict rscs according to the policy
+     *
+     * typically called once per frame
+     */
+    void tick();
+
+    void clearPool();
+
+    /**
+     * @brief track residency of all allocated rscs with given manager
+     *
+     * must be called before any rsc is allocated. rscs in use are pinned,
+     *  and pooled ones may be evicted. placed rscs are tracked by their heaps
+     */
+    void setResidencyManager(ResidencyManager *residencyMgr);
+
+    /**
+     * @brief mark rsc as referenced by the next submitted cmd lists
+     *
+     * rscs not allocated by this allocator are forwarded to the residency
+     *  manager directly
+     */
+    void useResidency(ID3D12Resource *rsc);
+
+    /**
+     * @brief heap stats from D3D12MA and category counters of this allocator
+     *
+     * 'frame' is the tick count. calculating heap stats walks all blocks,
+     *  so avoid calling it more than once per frame
+     */
+    AllocationStats getStats() const;
+
+    // relocation support used by ResourceDefragmenter
+
+    struct RelocationCandidate
+    {
+        ComPtr<ID3D12Resource> rsc;
+        D3D12_RESOURCE_STATES  state = {};
+
+        UINT64 size          = 0;
+        float  heapOccupancy = 0;
+    };
+
+    /**
+     * @brief in-use placed rscs in heaps whose occupancy is below
+     *  'maxOccupancy', ordered by ascending heap occupancy
+     */
+    std::vector<RelocationCandidate> getRelocationCandidates(
+        float maxOccupancy) const;
+
+    /**
+     * @brief destroy pooled rscs in heaps whose occupancy is below
+     *  'maxOccupancy'. returns destroyed bytes
+     */
+    UINT64 evictSparsePooledRscs(float maxOccupancy);
+
+    /**
+     * @brief create a new rsc with the same desc and state as 'rsc'
+     *
+     * returns nullptr if the new rsc would be placed in the same heap
+     */
+    ComPtr<ID3D12Resource> allocRelocationTarget(ID3D12Resource *rsc);
+
+    /**
+     * @brief let 'newRsc' take the place of 'oldRsc'
+     *
+     * freeing 'oldRsc' after this frees 'newRsc'. memory of 'oldRsc' is kept
+     *  until releaseRelocatedResource is called
+     */
+    void relocateResource(ID3D12Resource *oldRsc, ComPtr<ID3D12Resource> newRsc);
+
+    /**
+     * @brief release memory of a relocated rsc. gpu must no longer access it
+     */
+    void releaseRelocatedResource(ID3D12Resource *oldRsc);
+
+    /**
+     * @brief total bytes of all default heap blocks
+     */
+    UINT64 getTotalBlockBytes() const;
+
 private:
 
     struct D3D12MADeleter
@@ -48,11 +151,84 @@ private:
         }
     };
 
+    struct PoolKey
+    {
+        ResourceDesc          desc;
+        D3D12_RESOURCE_STATES state = {};
+
+        bool operator<(const PoolKey &rhs) const noexcept;
+    };
+
+    struct AllocatedRsc
+    {
+        D3D12MA::Allocation *allocation = nullptr;
+        PoolKey              key;
+    };
+
+    struct PooledRsc
+    {
+        ComPtr<ID3D12Resource> rsc;
+        D3D12MA::Allocation   *allocation = nullptr;
+        uint64_t               freeTick   = 0;
+    };
+
+    using Pool = std::multimap<PoolKey, PooledRsc>;
+
+    void evict(Pool::iterator it);
+
+    std::map<ID3D12Heap *, UINT64> getHeapUsedBytes() const;
+
+    static float getOccupancy(
+        const std::map<ID3D12Heap *, UINT64> &heapUsedBytes,
+        D3D12MA::Allocation                  *allocation);
+
+    // residency is managed per heap for placed rscs and per rsc for
+    // committed ones
+
+    struct PageableUsage
+    {
+        int allocationCount = 0;
+        int inUseCount      = 0;
+    };
+
+    static ID3D12Pageable *getPageable(D3D12MA::Allocation *allocation);
+
+    void onAllocationCreated(D3D12MA::Allocation *allocation);
+
+    void onAllocationInUse(D3D12MA::Allocation *allocation, bool inUse);
+
+    void onAllocationDestroyed(
+        D3D12MA::Allocation *allocation, const D3D12_RESOURCE_DESC &desc);
+
     std::unique_ptr<D3D12MA::Allocator, D3D12MADeleter> d3d12MemAlloc_;
 
-    std::map<ComPtr<ID3D12Resource>, D3D12MA::Allocation*> allocatedRscs_;
+    std::map<ComPtr<ID3D12Resource>, AllocatedRsc> allocatedRscs_;
+
+    uint64_t curTick_        = 0;
+    uint64_t maxUnusedTicks_ = 180;
+    UINT64   maxPoolBytes_   = UINT64(256) << 20;
+    UINT64   pooledBytes_    = 0;
+
+    Pool pool_;
+
+    ResidencyManager *residencyMgr_ = nullptr;
+
+    std::map<ID3D12Pageable *, PageableUsage> pageables_;
+
+    AllocationCounter categoryCounters_[ALLOCATION_CATEGORY_COUNT];
+
+    struct Relocation
+    {
+        ComPtr<ID3D12Resource> oldRsc;
+        ComPtr<ID3D12Resource> newRsc;
+    };
+
+    // old rsc -> rsc taking its place. old rscs are held so that their
+    // addresses are not reused by new rscs
+    std::map<ID3D12Resource *, Relocation> relocations_;
+
+    // relocated rscs whose memory is not released yet
+    std::map<ID3D12Resource *, AllocatedRsc> relocatedRscs_;
 };
 
 AGZ_D3D12_FG_END
-
-#include "./impl/resourceManager.inl"
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+
+#include <d3d12.h>
+
+#include <agz/d3d12/cmd/singleCmdList.h>
+#include <agz/d3d12/framegraph/resourceAllocator.h>
+
+AGZ_D3D12_FG_BEGIN
+
+/**
+ * @brief incrementally move rscs out of sparse placed heaps
+ *
+ * each update:
+ *  - releases memory of rscs whose relocation copies are finished, and
+ *    destroys pooled rscs in sparse heaps
+ *  - moves at most 'bytesPerFrame' bytes of in-use rscs from heaps whose
+ *    occupancy is below 'maxOccupancy' into denser heaps. contents are copied
+ *    on the copy queue, and relocation callbacks are invoked immediately so
+ *    that following cmd lists reference the new rscs
+ *
+ * depth stencil and multisampled rscs are never moved, as they can not be
+ *  copied on the copy queue.
+ *
+ * NOT thread-safe.
+ */
+class ResourceDefragmenter : public misc::uncopyable_t
+{
+public:
+
+    using RelocationCallback = std::function<
+        void(ID3D12Resource *oldRsc, ID3D12Resource *newRsc)>;
+
+    ResourceDefragmenter(
+        ID3D12Device              *device,
+        ResourceAllocator         &rscAlloc,
+        ID3D12CommandQueue        *graphicsQueue,
+        ComPtr<ID3D12CommandQueue> copyQueue);
+
+    ~ResourceDefragmenter();
+
+    void setBudget(UINT64 bytesPerFrame, float maxOccupancy);
+
+    /**
+     * @brief called when a rsc is replaced. descriptors and bindings
+     *  referencing 'oldRsc' must be updated to 'newRsc'
+     */
+    void addRelocationCallback(RelocationCallback callback);
+
+    /**
+     * @brief called once per frame, when no cmd list referencing rscs of the
+     *  allocator is being recorded
+     */
+    void update();
+
+    UINT64 getMovedBytes() const noexcept;
+
+    /**
+     * @brief heap bytes given back to the system by defragmentation
+     */
+    UINT64 getRecoveredBytes() const noexcept;
+
+private:
+
+    struct Move
+    {
+        ComPtr<ID3D12Resource> oldRsc;
+        ComPtr<ID3D12Resource> newRsc;
+        D3D12_RESOURCE_STATES  state;
+    };
+
+    struct CmdLists
+    {
+        UINT64 expectedFenceValue = 0;
+
+        SingleCommandList pre;
+        SingleCommandList copy;
+        SingleCommandList post;
+    };
+
+    struct PendingRelease
+    {
+        UINT64 fenceValue = 0;
+        ID3D12Resource *oldRsc = nullptr;
+    };
+
+    void releaseFinishedMoves();
+
+    std::vector<Move> selectMoves();
+
+    void submitMoves(const std::vector<Move> &moves);
+
+    ResourceAllocator &rscAlloc_;
+
+    ID3D12CommandQueue        *graphicsQueue_;
+    ComPtr<ID3D12CommandQueue> copyQueue_;
+
+    ComPtr<ID3D12Fence> fence_;
+    UINT64 nextFenceValue_;
+
+    std::vector<CmdLists> cmdLists_;
+    size_t curCmdListIdx_;
+
+    std::deque<PendingRelease> pendingReleases_;
+
+    std::vector<RelocationCallback> callbacks_;
+
+    UINT64 bytesPerFrame_;
+    float  maxOccupancy_;
+
+    UINT64 movedBytes_;
+    UINT64 recoveredBytes_;
+};
+
+AGZ_D3D12_FG_END
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <deque>
+
 #include <d3d12.h>
 
 #include <agz/d3d12/descriptor/descriptorHeap.h>
@@ -59,7 +61,11 @@ class ResourceReleaser
         UINT64 expectedFenceValue = 0;
     };
 
-    std::vector<Record> records_;
+    static void release(Record &record);
+
+    // records are appended in non-decreasing fence order, so completed ones
+    // are always at the front
+    std::deque<Record> records_;
 
     ComPtr<ID3D12Fence> fence_;
     UINT64 nextExpectedFenceValue_;
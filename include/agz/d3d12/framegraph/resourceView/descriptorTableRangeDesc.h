@@ -1,5 +1,7 @@
 #pragma once
 
+#include <climits>
+
 #include <d3d12.h>
 
 #include <agz/d3d12/framegraph/resourceView/shaderResourceViewDesc.h>
@@ -12,6 +14,13 @@ struct RangeSize
     UINT size = 1;
 };
 
+/**
+ * @brief unbounded descriptor range, mapped to 'Texture2D T[] : register(...)'
+ *
+ * must be the last range in the descriptor table
+ */
+inline constexpr RangeSize UNBOUNDED_RANGE = { UINT_MAX };
+
 /**
  * - RangeSize elem count of the descriptor range
  */
@@ -28,7 +37,7 @@ struct CBVRange
 };
 
 /**
- * - RangeSize elem count of the descriptor range
+ * - RangeSize elem count of the descriptor range. UNBOUNDED_RANGE for bindless
  */
 struct SRVRange
 {
@@ -43,7 +52,7 @@ struct SRVRange
 };
 
 /**
- * - RangeSize elem count of the descriptor range
+ * - RangeSize elem count of the descriptor range. UNBOUNDED_RANGE for bindless
  */
 struct UAVRange
 {
@@ -59,6 +59,14 @@ namespace detail
         g.scope = scope;
     }
 
+    template<typename S>
+    void _initBufSRV(
+        _internalSRV &g, S &s,
+        const FirstElement &firstElem) noexcept
+    {
+        s.FirstElement = firstElem.firstElem;
+    }
+
 } // namespace detail
 
 inline _internalSRV::_internalSRV(ResourceIndex rsc, SRVScope scope) noexcept
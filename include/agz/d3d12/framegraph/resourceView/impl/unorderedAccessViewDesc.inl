@@ -7,15 +7,15 @@ namespace detail
 
     template<typename S>
     void _initUAV(
-        D3D12_UNORDERED_ACCESS_VIEW_DESC &desc, S &s,
+        _internalUAV &g, S &s,
         DXGI_FORMAT format) noexcept
     {
-        desc.Format = format;
+        g.desc.Format = format;
     }
 
     template<typename S>
     void _initUAV(
-        D3D12_UNORDERED_ACCESS_VIEW_DESC &desc, S &s,
+        _internalUAV &g, S &s,
         const MipmapSlice &mipmapSlice) noexcept
     {
         s.MipSlice = mipmapSlice.sliceIdx;
@@ -23,17 +23,41 @@ namespace detail
 
     template<typename S>
     void _initUAV(
-        D3D12_UNORDERED_ACCESS_VIEW_DESC &desc, S &s, 
+        _internalUAV &g, S &s, 
         const ArraySlices &arraySlices) noexcept
     {
         s.FirstArraySlice = arraySlices.firstElem;
         s.ArraySize       = arraySlices.elemCount;
     }
 
+    template<typename S>
+    void _initUAV(
+        _internalUAV &g, S &s,
+        UAVAccess access) noexcept
+    {
+        g.access = access;
+    }
+
+    template<typename S>
+    void _initBufUAV(
+        _internalUAV &g, S &s,
+        UAVAccess access) noexcept
+    {
+        g.access = access;
+    }
+
+    template<typename S>
+    void _initBufUAV(
+        _internalUAV &g, S &s,
+        const FirstElement &firstElem) noexcept
+    {
+        s.FirstElement = firstElem.firstElem;
+    }
+
 } // namespace detail
 
 inline _internalUAV::_internalUAV(ResourceIndex rsc) noexcept
-    : rsc(rsc), desc{}
+    : rsc(rsc), desc{}, access(ReadWriteUAV)
 {
     desc.Format = DXGI_FORMAT_UNKNOWN;
 }
@@ -44,7 +68,7 @@ Tex2DUAV::Tex2DUAV(ResourceIndex rsc, const Args &... args) noexcept
 {
     desc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
     desc.Texture2D     = { 0, 0 };
-    InvokeAll([&] { detail::_initUAV(desc, desc.Texture2D, args); }...);
+    InvokeAll([&] { detail::_initUAV(*this, desc.Texture2D, args); }...);
 }
 
 template<typename ... Args>
@@ -53,11 +77,13 @@ Tex2DArrUAV::Tex2DArrUAV(ResourceIndex rsc, const Args &... args) noexcept
 {
     desc.ViewDimension  = D3D12_UAV_DIMENSION_TEXTURE2DARRAY;
     desc.Texture2DArray = { 0, 0, 1, 0 };
-    InvokeAll([&] { detail::_initUAV(desc, desc.Texture2DArray, args); }...);
+    InvokeAll([&] { detail::_initUAV(*this, desc.Texture2DArray, args); }...);
 }
 
 template<typename ... Args>
-BufUAV::BufUAV(ResourceIndex rsc, UINT elemSize, UINT elemCnt) noexcept
+BufUAV::BufUAV(
+    ResourceIndex rsc, UINT elemSize, UINT elemCnt,
+    const Args &... args) noexcept
     : _internalUAV(rsc)
 {
     desc.ViewDimension               = D3D12_UAV_DIMENSION_BUFFER;
@@ -66,6 +92,7 @@ BufUAV::BufUAV(ResourceIndex rsc, UINT elemSize, UINT elemCnt) noexcept
     desc.Buffer.Flags                = D3D12_BUFFER_UAV_FLAG_NONE;
     desc.Buffer.NumElements          = elemCnt;
     desc.Buffer.StructureByteStride  = elemSize;
+    InvokeAll([&] { detail::_initBufUAV(*this, desc.Buffer, args); }...);
 }
 
 AGZ_D3D12_FG_END
@@ -84,6 +84,7 @@ struct Tex2DMSArrSRV : _internalSRV
 };
 
 /**
+ * - FirstElement. index of first viewed element. default is 0
  * - SRVScope. accessible shader stages. default is 'DEFAULT' in which all
  *   shader stages can access it
  */
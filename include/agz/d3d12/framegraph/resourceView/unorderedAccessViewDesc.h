@@ -6,6 +6,17 @@
 
 AGZ_D3D12_FG_BEGIN
 
+enum UAVAccess
+{
+    // the resource may be read and written through this uav
+    ReadWriteUAV,
+    // the resource is only read through this uav
+    ReadOnlyUAV,
+    // the resource is written through this uav, and the written range never
+    // overlaps with ranges accessed by adjacent 'NonOverlappingWriteUAV's
+    NonOverlappingWriteUAV
+};
+
 struct _internalUAV
 {
     explicit _internalUAV(ResourceIndex rsc) noexcept;
@@ -13,11 +24,14 @@ struct _internalUAV
     ResourceIndex rsc;
 
     D3D12_UNORDERED_ACCESS_VIEW_DESC desc;
+
+    UAVAccess access;
 };
 
 /**
  * - DXGI_FORMAT. default is UNKNOWN (inferred from rsc)
  * - MipmapSlice. mipmap slice of rsc. default is 0
+ * - UAVAccess. how the rsc is accessed. default is 'ReadWriteUAV'
  */
 struct Tex2DUAV : _internalUAV
 {
@@ -29,6 +43,7 @@ struct Tex2DUAV : _internalUAV
  * - DXGI_FORMAT. default is UNKNOWN (inferred from rsc)
  * - MipmapSlice. mipmap slice of rsc. default is 0
  * - ArraySlices. array elems of rsc. default is [0]
+ * - UAVAccess. how the rsc is accessed. default is 'ReadWriteUAV'
  */
 struct Tex2DArrUAV : _internalUAV
 {
@@ -36,10 +51,16 @@ struct Tex2DArrUAV : _internalUAV
     explicit Tex2DArrUAV(ResourceIndex rsc, const Args &...args) noexcept;
 };
 
+/**
+ * - FirstElement. index of first viewed element. default is 0
+ * - UAVAccess. how the rsc is accessed. default is 'ReadWriteUAV'
+ */
 struct BufUAV : _internalUAV
 {
     template<typename...Args>
-    BufUAV(ResourceIndex rsc, UINT elemSize, UINT elemCnt) noexcept;
+    BufUAV(
+        ResourceIndex rsc, UINT elemSize, UINT elemCnt,
+        const Args &...args) noexcept;
 };
 
 AGZ_D3D12_FG_END
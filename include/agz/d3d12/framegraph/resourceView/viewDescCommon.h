@@ -24,4 +24,14 @@ struct MipmapSlices
     float minLODClamp = 0;
 };
 
+/**
+ * @brief first element of a buffer view
+ *
+ * used to view a range of a shared buffer block. see BufferRange::getFirstElement
+ */
+struct FirstElement
+{
+    UINT64 firstElem = 0;
+};
+
 AGZ_D3D12_FG_END
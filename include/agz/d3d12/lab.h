@@ -1,5 +1,12 @@
 #pragma once
 
+#include <agz/d3d12/asset/chunkedLZ4.h>
+#include <agz/d3d12/asset/lz4.h>
+#include <agz/d3d12/asset/mappedFile.h>
+#include <agz/d3d12/asset/packedAssetFile.h>
+#include <agz/d3d12/asset/xxHash64.h>
+
+#include <agz/d3d12/buffer/bufferSuballocator.h>
 #include <agz/d3d12/buffer/constantBuffer.h>
 #include <agz/d3d12/buffer/vertexBuffer.h>
 
@@ -8,12 +15,21 @@
 #include <agz/d3d12/cmd/perFrameCmdList.h>
 #include <agz/d3d12/cmd/singleCmdList.h>
 
+#include <agz/d3d12/descriptor/bindlessTable.h>
+#include <agz/d3d12/descriptor/concurrentDescriptorAllocator.h>
 #include <agz/d3d12/descriptor/rawDescriptorHeap.h>
 #include <agz/d3d12/descriptor/descriptorHeap.h>
+#include <agz/d3d12/descriptor/descriptorTableBuilder.h>
+#include <agz/d3d12/descriptor/singleDescriptorPool.h>
+#include <agz/d3d12/descriptor/transientDescriptorRing.h>
 
+#include <agz/d3d12/framegraph/commandSignatureCache.h>
+#include <agz/d3d12/framegraph/copySource.h>
 #include <agz/d3d12/framegraph/framegraph.h>
+#include <agz/d3d12/framegraph/indirectArgs.h>
 #include <agz/d3d12/framegraph/passContext.h>
 #include <agz/d3d12/framegraph/pipelineState.h>
+#include <agz/d3d12/framegraph/resourceDefragmenter.h>
 #include <agz/d3d12/framegraph/rootSignature.h>
 
 #include <agz/d3d12/framegraph/resourceView/depthStencilViewDesc.h>
@@ -25,14 +41,21 @@
 
 #include <agz/d3d12/imgui/imguiIntegration.h>
 
+#include <agz/d3d12/memory/allocationStats.h>
+#include <agz/d3d12/memory/residencyManager.h>
+
 #include <agz/d3d12/pipeline/pipelineState.h>
 #include <agz/d3d12/pipeline/shader.h>
 
 #include <agz/d3d12/sync/cmdQueueWaiter.h>
+#include <agz/d3d12/sync/fencedRingAllocator.h>
 #include <agz/d3d12/sync/frameResourceFence.h>
+#include <agz/d3d12/sync/resourceReadback.h>
 #include <agz/d3d12/sync/resourceUploader.h>
+#include <agz/d3d12/sync/uploadCache.h>
 
 #include <agz/d3d12/texture/depthStencilBuffer.h>
+#include <agz/d3d12/texture/formatInfo.h>
 #include <agz/d3d12/texture/mipmap.h>
 #include <agz/d3d12/texture/texture2d.h>
 
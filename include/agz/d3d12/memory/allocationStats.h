@@ -0,0 +1,126 @@
+#pragma once
+
+#include <string>
+
+#include <d3d12.h>
+
+#include <agz/d3d12/common.h>
+
+AGZ_D3D12_BEGIN
+
+enum class AllocationCategory
+{
+    RenderTarget,
+    DepthStencil,
+    UnorderedAccess,
+    Buffer,
+    Texture,
+    Upload,
+    Count
+};
+
+constexpr int ALLOCATION_CATEGORY_COUNT =
+    static_cast<int>(AllocationCategory::Count);
+
+const char *getAllocationCategoryName(AllocationCategory category) noexcept;
+
+/**
+ * @brief classify a rsc by its heap type and flags
+ *
+ * non-default heaps are 'Upload'. otherwise rt/ds/uav flags take precedence
+ *  over dimension
+ */
+AllocationCategory getAllocationCategory(
+    const D3D12_RESOURCE_DESC &desc, D3D12_HEAP_TYPE heapType) noexcept;
+
+/**
+ * @brief live/peak counters of allocations in one category
+ */
+struct AllocationCounter
+{
+    UINT64 liveBytes  = 0;
+    UINT64 liveCount  = 0;
+    UINT64 peakBytes  = 0;
+    UINT64 peakCount  = 0;
+    UINT64 allocCount = 0;
+
+    void onAlloc(UINT64 bytes) noexcept;
+
+    void onFree(UINT64 bytes) noexcept;
+
+    /**
+     * @brief add counts of another counter
+     *
+     * peaks are summed, which bounds the peak of both counters together
+     */
+    void merge(const AllocationCounter &other) noexcept;
+};
+
+/**
+ * @brief occupancy of memory blocks of one heap type
+ */
+struct HeapStats
+{
+    UINT   blockCount       = 0;
+    UINT   allocationCount  = 0;
+    UINT   unusedRangeCount = 0;
+    UINT64 usedBytes        = 0;
+    UINT64 unusedBytes      = 0;
+    UINT64 maxUnusedRange   = 0;
+
+    /**
+     * @brief 1 - maxUnusedRange / unusedBytes
+     *
+     * 0 when all unused bytes are in a single range
+     */
+    float getFragmentation() const noexcept;
+};
+
+/**
+ * @brief snapshot of allocation telemetry
+ *
+ * heaps are indexed by 0 - DEFAULT, 1 - UPLOAD, 2 - READBACK
+ *
+ * the frame graph allocates no rsc of the 'Upload' category. staging and
+ *  readback rings are counted by their owners and merged by 'addUploadCounter'
+ */
+struct AllocationStats
+{
+    UINT64 frame = 0;
+
+    HeapStats total;
+    HeapStats heaps[3];
+
+    AllocationCounter categories[ALLOCATION_CATEGORY_COUNT];
+
+    // bytes of freed rscs kept for reusing
+    UINT64 pooledBytes = 0;
+
+    AllocationCounter &operator[](AllocationCategory category) noexcept;
+
+    const AllocationCounter &operator[](
+        AllocationCategory category) const noexcept;
+
+    /**
+     * @brief merge counter into the 'Upload' category, e.g.
+     *  ResourceUploader::getStagingCounter or ResourceReadback::getRingCounter
+     */
+    AllocationStats &addUploadCounter(
+        const AllocationCounter &counter) noexcept;
+
+    /**
+     * @brief single-line json object. suitable for appending one line per
+     *  frame to a log file
+     */
+    std::string toJSON() const;
+};
+
+/**
+ * @brief draw stats in an imgui window
+ *
+ * must be called between ImGui::NewFrame and ImGui::Render
+ */
+void showAllocationStatsWindow(
+    const AllocationStats &stats, bool *open = nullptr);
+
+AGZ_D3D12_END
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <map>
+#include <memory>
+
+#include <d3d12.h>
+#include <dxgi1_4.h>
+
+#include <agz/d3d12/memory/residencyTracker.h>
+#include <agz/utility/misc.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief budget source backed by IDXGIAdapter3::QueryVideoMemoryInfo
+ */
+class DXGIBudgetSource : public BudgetSource
+{
+public:
+
+    explicit DXGIBudgetSource(IDXGIAdapter *adapter);
+
+    UINT64 getBudget() override;
+
+    UINT64 getUsage() override;
+
+private:
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO query() const;
+
+    ComPtr<IDXGIAdapter3> adapter_;
+};
+
+/**
+ * @brief evict lru objects when the process exceeds its video memory budget
+ *
+ * usage:
+ *  - track objects. ResourceAllocator and ResourceUploader do this
+ *    automatically when a residency manager is set to them
+ *  - call 'use' on objects referenced by a cmd list, and 'makeResident'
+ *    before executing it
+ *  - call 'addUsePoint' on the queue after executing cmd lists referencing
+ *    used objects
+ *  - call 'startFrame' once per frame to enforce the budget
+ *
+ * an object is only evicted when it is not pinned and the use point after
+ *  its last 'use' is reached on gpu. objects used on queues signaling no use
+ *  point, like the copy queue of ResourceUploader, must be pinned until those
+ *  cmd lists are finished.
+ *
+ * the manager holds a reference to each tracked object. objects referenced
+ *  only by the manager are untracked in 'startFrame'.
+ *
+ * NOT thread-safe.
+ */
+class ResidencyManager : public misc::uncopyable_t
+{
+public:
+
+    ResidencyManager(
+        ComPtr<ID3D12Device>          device,
+        std::unique_ptr<BudgetSource> budgetSource);
+
+    ResidencyManager(ComPtr<ID3D12Device> device, IDXGIAdapter *adapter);
+
+    /**
+     * @brief start tracking an object. do nothing if it is already tracked
+     *
+     * 'pinned' adds one pin, which must be removed by 'unpin' to make the
+     *  object evictable
+     */
+    void track(ComPtr<ID3D12Pageable> obj, UINT64 size, bool pinned);
+
+    /**
+     * @brief track a rsc with its allocation size
+     */
+    void track(ComPtr<ID3D12Resource> rsc, bool pinned);
+
+    /**
+     * @brief stop tracking an object
+     *
+     * an evicted object is left evicted. this is intended to be called before
+     *  the object is destroyed
+     */
+    void untrack(ID3D12Pageable *obj);
+
+    bool isTracked(ID3D12Pageable *obj) const;
+
+    /**
+     * @brief pinned objects are never evicted. pins are counted
+     */
+    void pin(ID3D12Pageable *obj);
+
+    void unpin(ID3D12Pageable *obj);
+
+    /**
+     * @brief mark obj as referenced by the cmd lists executed before the next
+     *  use point
+     *
+     * untracked objects are ignored
+     */
+    void use(ID3D12Pageable *obj);
+
+    /**
+     * @brief make all used objects resident. call before executing cmd lists
+     *  referencing them
+     */
+    void makeResident();
+
+    /**
+     * @brief signal a use point on cmdQueue
+     *
+     * objects used since the last use point are evictable after the signal
+     *  is reached
+     */
+    void addUsePoint(ID3D12CommandQueue *cmdQueue);
+
+    /**
+     * @brief untrack orphan objects and evict lru objects until usage is
+     *  under budget
+     */
+    void startFrame();
+
+    UINT64 getBudget();
+
+    UINT64 getUsage();
+
+    const ResidencyTracker &getTracker() const noexcept;
+
+private:
+
+    void untrackOrphans();
+
+    void remove(ID3D12Pageable *obj);
+
+    void enforceBudget();
+
+    ComPtr<ID3D12Device> device_;
+
+    std::unique_ptr<BudgetSource> budgetSource_;
+
+    ResidencyTracker tracker_;
+
+    std::map<ID3D12Pageable *, ComPtr<ID3D12Pageable>> objs_;
+
+    std::vector<ID3D12Pageable *> pendingResidentObjs_;
+
+    // signaled by use points
+    ComPtr<ID3D12Fence> fence_;
+    UINT64              nextUseFenceValue_;
+};
+
+AGZ_D3D12_END
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <agz/d3d12/common.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief source of local video memory budget
+ */
+class BudgetSource
+{
+public:
+
+    virtual ~BudgetSource() = default;
+
+    /**
+     * @brief bytes of video memory the os allows this process to use
+     */
+    virtual UINT64 getBudget() = 0;
+
+    /**
+     * @brief bytes of video memory currently used by this process
+     */
+    virtual UINT64 getUsage() = 0;
+};
+
+/**
+ * @brief lru list and byte accounting of tracked objects
+ *
+ * contains no d3d12 call. objects are identified by opaque keys.
+ *
+ * pinned objects (e.g. framegraph rscs in use or rscs being uploaded) are
+ *  accounted but never chosen for eviction. the others are only chosen when
+ *  the fence value of their last use is completed, as they may be referenced
+ *  by in-flight cmd lists before that.
+ */
+class ResidencyTracker
+{
+public:
+
+    using Key = const void *;
+
+    ResidencyTracker();
+
+    /**
+     * @brief start tracking a resident object
+     *
+     * 'pinned' adds one pin, which is removed by 'unpin'
+     */
+    void add(Key key, UINT64 size, bool pinned);
+
+    void remove(Key key);
+
+    bool contains(Key key) const;
+
+    /**
+     * @brief pins are counted. an object is evictable when it has no pin
+     */
+    void pin(Key key);
+
+    void unpin(Key key);
+
+    bool isPinned(Key key) const;
+
+    /**
+     * @brief mark an object as referenced by cmd lists which are finished
+     *  when the fence value reaches 'fenceValue'
+     *
+     * returns true if the object was evicted and must be made resident before
+     *  any cmd list referencing it is executed. it is accounted as resident
+     *  since then
+     */
+    bool use(Key key, UINT64 fenceValue);
+
+    /**
+     * @brief choose lru evictable objects until 'usage' minus bytes of chosen
+     *  objects is no more than 'budget'
+     *
+     * objects last used with a fence value greater than 'completedFenceValue'
+     *  are skipped. chosen objects are accounted as evicted
+     */
+    std::vector<Key> evictToBudget(
+        UINT64 usage, UINT64 budget, UINT64 completedFenceValue);
+
+    bool isResident(Key key) const;
+
+    UINT64 getResidentBytes() const noexcept;
+
+    UINT64 getEvictedBytes() const noexcept;
+
+private:
+
+    struct Entry
+    {
+        Key    key          = nullptr;
+        UINT64 size         = 0;
+        int    pinCount     = 0;
+        bool   resident     = true;
+        UINT64 lastUseFence = 0;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    UINT64 residentBytes_;
+    UINT64 evictedBytes_;
+
+    // front is the most recently used
+    EntryList lru_;
+
+    std::unordered_map<Key, EntryList::iterator> entries_;
+};
+
+inline ResidencyTracker::ResidencyTracker()
+    : residentBytes_(0), evictedBytes_(0)
+{
+
+}
+
+inline void ResidencyTracker::add(Key key, UINT64 size, bool pinned)
+{
+    assert(!contains(key));
+
+    lru_.push_front({ key, size, pinned ? 1 : 0, true, 0 });
+    entries_[key] = lru_.begin();
+
+    residentBytes_ += size;
+}
+
+inline void ResidencyTracker::remove(Key key)
+{
+    const auto it = entries_.find(key);
+    if(it == entries_.end())
+        return;
+
+    const auto &e = *it->second;
+    (e.resident ? residentBytes_ : evictedBytes_) -= e.size;
+
+    lru_.erase(it->second);
+    entries_.erase(it);
+}
+
+inline bool ResidencyTracker::contains(Key key) const
+{
+    return entries_.find(key) != entries_.end();
+}
+
+inline void ResidencyTracker::pin(Key key)
+{
+    const auto it = entries_.find(key);
+    if(it != entries_.end())
+        ++it->second->pinCount;
+}
+
+inline void ResidencyTracker::unpin(Key key)
+{
+    const auto it = entries_.find(key);
+    if(it != entries_.end())
+    {
+        assert(it->second->pinCount > 0);
+        --it->second->pinCount;
+    }
+}
+
+inline bool ResidencyTracker::isPinned(Key key) const
+{
+    const auto it = entries_.find(key);
+    return it != entries_.end() && it->second->pinCount > 0;
+}
+
+inline bool ResidencyTracker::use(Key key, UINT64 fenceValue)
+{
+    const auto it = entries_.find(key);
+    if(it == entries_.end())
+        return false;
+
+    auto &e = *it->second;
+    e.lastUseFence = (std::max)(e.lastUseFence, fenceValue);
+
+    lru_.splice(lru_.begin(), lru_, it->second);
+
+    if(e.resident)
+        return false;
+
+    e.resident      = true;
+    evictedBytes_  -= e.size;
+    residentBytes_ += e.size;
+
+    return true;
+}
+
+inline std::vector<ResidencyTracker::Key> ResidencyTracker::evictToBudget(
+    UINT64 usage, UINT64 budget, UINT64 completedFenceValue)
+{
+    std::vector<Key> ret;
+
+    for(auto it = lru_.rbegin(); it != lru_.rend() && usage > budget; ++it)
+    {
+        auto &e = *it;
+
+        if(e.pinCount || !e.resident || e.lastUseFence > completedFenceValue)
+            continue;
+
+        e.resident      = false;
+        residentBytes_ -= e.size;
+        evictedBytes_  += e.size;
+
+        usage = usage > e.size ? usage - e.size : 0;
+
+        ret.push_back(e.key);
+    }
+
+    return ret;
+}
+
+inline bool ResidencyTracker::isResident(Key key) const
+{
+    const auto it = entries_.find(key);
+    return it != entries_.end() && it->second->resident;
+}
+
+inline UINT64 ResidencyTracker::getResidentBytes() const noexcept
+{
+    return residentBytes_;
+}
+
+inline UINT64 ResidencyTracker::getEvictedBytes() const noexcept
+{
+    return evictedBytes_;
+}
+
+AGZ_D3D12_END
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+#include <agz/d3d12/common.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief bump-pointer ring allocator retired by frame fence values
+ *
+ * contains no d3d12 object. allocations are contiguous in [0, capacity).
+ *  all allocations made between two 'endFrame' calls are retired together
+ *  once the fence value passed to the latter one is completed, so the ring
+ *  never wraps over a frame that may still be in flight.
+ */
+class FencedRingAllocator
+{
+public:
+
+    explicit FencedRingAllocator(uint64_t capacity = 0) noexcept;
+
+    void initialize(uint64_t capacity) noexcept;
+
+    /**
+     * @brief returns offset of allocated space
+     *
+     * returns nullopt when there is not enough retired space. the tail of the
+     *  ring is skipped when the allocation does not fit in it
+     */
+    std::optional<uint64_t> alloc(uint64_t size, uint64_t alignment = 1) noexcept;
+
+    /**
+     * @brief tag allocations since last call with fence value
+     *
+     * fence values must be non-decreasing
+     */
+    void endFrame(uint64_t fenceValue);
+
+    /**
+     * @brief free space of frames whose fence value is no more than
+     *  'completedFenceValue'
+     */
+    void retire(uint64_t completedFenceValue) noexcept;
+
+    /**
+     * @brief fence value of the oldest unretired frame. nullopt if none
+     */
+    std::optional<uint64_t> getOldestFenceValue() const noexcept;
+
+    uint64_t getCapacity() const noexcept;
+
+    uint64_t getUsedSize() const noexcept;
+
+private:
+
+    struct Frame
+    {
+        uint64_t fenceValue = 0;
+        uint64_t end        = 0;
+    };
+
+    uint64_t capacity_;
+
+    // monotonic positions. offset in ring is position % capacity
+    uint64_t head_;
+    uint64_t tail_;
+
+    std::deque<Frame> frames_;
+};
+
+inline FencedRingAllocator::FencedRingAllocator(uint64_t capacity) noexcept
+    : capacity_(capacity), head_(0), tail_(0)
+{
+
+}
+
+inline void FencedRingAllocator::initialize(uint64_t capacity) noexcept
+{
+    capacity_ = capacity;
+    head_     = 0;
+    tail_     = 0;
+    frames_.clear();
+}
+
+inline std::optional<uint64_t> FencedRingAllocator::alloc(
+    uint64_t size, uint64_t alignment) noexcept
+{
+    assert(alignment && capacity_ % alignment == 0);
+
+    if(size > capacity_)
+        return std::nullopt;
+
+    // an empty ring restarts from offset 0, so no tail is skipped. unretired
+    // frames of it are empty and end at head
+
+    if(head_ == tail_)
+    {
+        for(auto &frame : frames_)
+            frame.end = 0;
+        head_ = 0;
+        tail_ = 0;
+    }
+
+    const uint64_t offset = head_ % capacity_;
+    uint64_t alignedOffset = (offset + alignment - 1) / alignment * alignment;
+
+    uint64_t start = head_ + (alignedOffset - offset);
+    if(alignedOffset + size > capacity_)
+    {
+        // skip the tail of the ring
+        start += capacity_ - alignedOffset;
+        alignedOffset = 0;
+    }
+
+    if(start + size - tail_ > capacity_)
+        return std::nullopt;
+
+    head_ = start + size;
+    return alignedOffset;
+}
+
+inline void FencedRingAllocator::endFrame(uint64_t fenceValue)
+{
+    assert(frames_.empty() || frames_.back().fenceValue <= fenceValue);
+    frames_.push_back({ fenceValue, head_ });
+}
+
+inline void FencedRingAllocator::retire(uint64_t completedFenceValue) noexcept
+{
+    while(!frames_.empty() && frames_.front().fenceValue <= completedFenceValue)
+    {
+        tail_ = frames_.front().end;
+        frames_.pop_front();
+    }
+}
+
+inline std::optional<uint64_t>
+    FencedRingAllocator::getOldestFenceValue() const noexcept
+{
+    if(frames_.empty())
+        return std::nullopt;
+    return frames_.front().fenceValue;
+}
+
+inline uint64_t FencedRingAllocator::getCapacity() const noexcept
+{
+    return capacity_;
+}
+
+inline uint64_t FencedRingAllocator::getUsedSize() const noexcept
+{
+    return head_ - tail_;
+}
+
+AGZ_D3D12_END
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <d3d12.h>
+
+#include <agz/d3d12/cmd/singleCmdList.h>
+#include <agz/d3d12/framegraph/framegraph.h>
+#include <agz/d3d12/memory/allocationStats.h>
+#include <agz/d3d12/sync/fencedRingAllocator.h>
+#include <agz/d3d12/window/window.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief read gpu data back to cpu without waiting for queues to be idle
+ *
+ * data is copied into persistently mapped readback rings, whose space is
+ *  reclaimed by fence value of submissions. results are copied out of the
+ *  rings and resolved in 'collect', so the cpu only waits for gpu when a
+ *  ring is full or 'waitForIdle' is called.
+ *
+ * 'readBuffer' and 'readTex2D' copy on the copy queue, which waits for
+ *  graphics work executed before the next 'submit'. the rscs must be in
+ *  COMMON state by then, e.g. decayed from implicitly promoted states or
+ *  transitioned by the caller.
+ *
+ * 'recordReadback' copies on a caller cmd list, typically in a frame graph
+ *  pass declaring the rsc with fg::CopySource (see 'addReadbackPass'). such
+ *  readbacks are finished with the first 'submit' after the cmd list is
+ *  executed on the graphics queue.
+ */
+class ResourceReadback : public misc::uncopyable_t
+{
+public:
+
+    static constexpr UINT64 DEFAULT_RING_SIZE = UINT64(16) << 20;
+
+    /**
+     * @brief read back data
+     *
+     * for textures, rows of blocks (texels for uncompressed formats) are
+     *  tightly packed. rowSize is the byte size of a row and rowCount is the
+     *  number of rows. for buffers, rowSize is the byte size and rowCount is 1
+     */
+    struct Result
+    {
+        std::vector<unsigned char> data;
+
+        UINT64 rowSize  = 0;
+        UINT   rowCount = 0;
+    };
+
+    using Callback = std::function<void(const Result &)>;
+
+    /**
+     * @brief handle of a readback. becomes ready in ResourceReadback::collect
+     */
+    class Future
+    {
+    public:
+
+        bool isValid() const noexcept;
+
+        bool isReady() const noexcept;
+
+        /**
+         * @brief throws when not ready
+         */
+        const Result &get() const;
+
+    private:
+
+        friend class ResourceReadback;
+
+        struct State
+        {
+            bool   isReady = false;
+            Result result;
+        };
+
+        std::shared_ptr<State> state_;
+    };
+
+    ResourceReadback(
+        ComPtr<ID3D12Device>       device,
+        ComPtr<ID3D12CommandQueue> copyQueue,
+        ComPtr<ID3D12CommandQueue> graphicsQueue,
+        size_t                     ringCmdListCount,
+        UINT64                     ringSize = DEFAULT_RING_SIZE);
+
+    ResourceReadback(
+        Window &window,
+        size_t  ringCmdListCount,
+        UINT64  ringSize = DEFAULT_RING_SIZE);
+
+    ~ResourceReadback();
+
+    /**
+     * @brief read a range of buffer on copy queue
+     *
+     * callback is invoked in 'collect' after the future becomes ready
+     */
+    Future readBuffer(
+        ComPtr<ID3D12Resource> src,
+        UINT64                 offset,
+        UINT64                 byteSize,
+        Callback               callback = {});
+
+    /**
+     * @brief read a subrsc of texture on copy queue
+     */
+    Future readTex2D(
+        ComPtr<ID3D12Resource> src,
+        UINT                   subrsc,
+        Callback               callback = {});
+
+    /**
+     * @brief record a copy of a whole buffer or a subrsc of texture into
+     *  cmdList. src must be in COPY_SOURCE state when cmdList is executed
+     *
+     * thread-safe. space of such copies is allocated from a separate ring,
+     *  which cannot be waited for before the cmd list is executed. so the
+     *  readback is skipped and an invalid future is returned when the ring is
+     *  full
+     */
+    Future recordReadback(
+        ID3D12GraphicsCommandList *cmdList,
+        ComPtr<ID3D12Resource>     src,
+        UINT                       subrsc   = 0,
+        Callback                   callback = {});
+
+    /**
+     * @brief add a pass reading back rsc every time the graph is executed
+     *
+     * the pass runs after previous writers of rsc. callback is invoked in
+     *  'collect' with data of each execution
+     */
+    fg::PassIndex addReadbackPass(
+        fg::FrameGraph   &graph,
+        fg::ResourceIndex rsc,
+        Callback          callback,
+        UINT              subrsc = 0);
+
+    /**
+     * @brief number of readbacks skipped by 'recordReadback' for lack of
+     *  ring space
+     */
+    UINT64 getSkippedReadbackCount() const;
+
+    /**
+     * @brief counter of the readback rings. merge it with
+     *  AllocationStats::addUploadCounter
+     */
+    const AllocationCounter &getRingCounter() const noexcept;
+
+    /**
+     * @brief submit copies of 'readBuffer' and 'readTex2D', and finish
+     *  'recordReadback' copies in cmd lists executed before
+     *
+     * typically called once per frame after executing the frame graph
+     */
+    void submit();
+
+    /**
+     * @brief resolve finished readbacks, invoke their callbacks and reclaim
+     *  ring space
+     */
+    void collect();
+
+    /**
+     * @brief submit and wait for all readbacks. then collect them
+     */
+    void waitForIdle();
+
+private:
+
+    struct Request
+    {
+        UINT64 fenceValue = 0;
+
+        ComPtr<ID3D12Resource> src;
+
+        bool   isBuffer  = true;
+        UINT64 srcOffset = 0; // for buffers
+        UINT   subrsc    = 0; // for textures
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+
+        UINT64 offset   = 0; // in ring
+        UINT64 rowPitch = 0;
+        UINT64 rowSize  = 0;
+        UINT   rowCount = 0;
+
+        std::shared_ptr<Future::State> state;
+        Callback callback;
+    };
+
+    struct Channel
+    {
+        ComPtr<ID3D12Resource> buffer;
+        unsigned char         *data = nullptr;
+        FencedRingAllocator    ring;
+
+        // signaled by submissions of this channel
+        ComPtr<ID3D12Fence> fence;
+        UINT64              nextFenceValue = 1;
+
+        std::vector<Request> recordedRequests;
+        std::deque<Request>  submittedRequests;
+    };
+
+    struct RingCmdList
+    {
+        UINT64            expectedFenceValue = 0;
+        SingleCommandList copyCmdList;
+    };
+
+    void initChannel(Channel &channel, UINT64 ringSize);
+
+    void destroyChannel(Channel &channel);
+
+    // fill layout of request and allocate its ring space. returns false when
+    // the ring is full. for buffers, request.rowSize is the byte size to read
+    bool allocRequest(Channel &channel, Request &request);
+
+    // submits copy cmd list and waits for old readbacks when the copy ring is
+    // full. graphics channel is left to 'submit'
+    void allocCopyRequest(Request &request);
+
+    // signal graphics fence without finishing any recordReadback copy.
+    // graphicsMutex_ must be held
+    UINT64 signalGraphicsFence();
+
+    // submit current copy cmd list after graphics fence reaches given value
+    void submitCopyCmdList(UINT64 graphicsFenceValue);
+
+    Future recordRequest(
+        ID3D12GraphicsCommandList *cmdList,
+        Channel                   &channel,
+        Request                    request,
+        Callback                   callback);
+
+    // tag recorded requests and ring space with fence value
+    static void endChannelFrame(Channel &channel, UINT64 fenceValue);
+
+    // copy out data of finished requests and reclaim their space
+    void resolveChannel(Channel &channel, UINT64 completedFenceValue);
+
+    ComPtr<ID3D12Device>       device_;
+    ComPtr<ID3D12CommandQueue> copyQueue_;
+    ComPtr<ID3D12CommandQueue> graphicsQueue_;
+
+    // readBuffer & readTex2D. used by the owning thread only
+    Channel copyChannel_;
+
+    std::vector<RingCmdList> cmdLists_;
+    size_t                   curCmdListIdx_;
+    bool                     isCopyCmdListDirty_;
+
+    // recordReadback. its fence is signaled on graphics queue and also
+    // waited by copy queue before copying
+    mutable std::mutex graphicsMutex_;
+    Channel            graphicsChannel_;
+    UINT64             skippedReadbackCount_;
+
+    // requests resolved since last collect whose callbacks are not invoked
+    std::vector<Request> resolvedRequests_;
+
+    AllocationCounter ringCounter_;
+};
+
+AGZ_D3D12_END
@@ -1,17 +1,66 @@
 #pragma once
 
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
 #include <d3d12.h>
 
+#include <agz/utility/thread.h>
+
+#include <agz/d3d12/asset/chunkedLZ4.h>
 #include <agz/d3d12/buffer/buffer.h>
+#include <agz/d3d12/buffer/bufferSuballocator.h>
 #include <agz/d3d12/cmd/singleCmdList.h>
+#include <agz/d3d12/memory/residencyManager.h>
+#include <agz/d3d12/sync/fencedRingAllocator.h>
 #include <agz/d3d12/window/window.h>
 
 AGZ_D3D12_BEGIN
 
+/**
+ * @brief upload data to default heap rscs with copy queue
+ *
+ * staging data is written into a persistently mapped upload ring, whose space
+ *  is reclaimed by fence value of submissions. uploads larger than half of
+ *  the ring are split into chunks. the uploader submits pending cmds and waits
+ *  for old submissions when the ring is full.
+ *
+ * uploaded rscs are in afterState when the upload is finished. transitions
+ *  to it are collected and recorded by one ResourceBarrier call on the
+ *  graphics queue when submitting. passing COMMON as afterState records no
+ *  graphics work at all, and relies on implicit promotion on first gpu
+ *  access: buffers and simultaneous-access textures are promoted to any
+ *  state, other textures only to shader resource and copy states. rscs whose
+ *  state is tracked by the caller, e.g. external rscs of frame graphs, should
+ *  be uploaded with the state the caller assumes instead.
+ *
+ * uploads can also be prepared on worker threads with ThreadContext.
+ */
 class ResourceUploader : public misc::uncopyable_t
 {
+    // staging ring and cmd lists used by one recording thread
+    struct Recorder;
+
 public:
 
+    static constexpr UINT64 DEFAULT_STAGING_RING_SIZE = UINT64(32) << 20;
+
+    static constexpr UINT64 DEFAULT_THREAD_STAGING_RING_SIZE = UINT64(8) << 20;
+
+    using UploadTicket = UINT64;
+
+    using UploadCallback = std::function<void()>;
+
+    /**
+     * @brief data of a subrsc
+     *
+     * rowSize is the byte distance between rows of blocks (texels for
+     *  uncompressed formats). 0 for tightly packed data
+     */
     struct Tex2DSubInitData
     {
         Tex2DSubInitData(
@@ -25,23 +74,143 @@ public:
         size_t rowSize;
     };
 
+    /**
+     * @brief data of all subrscs, in order of mips of each array slice
+     *
+     * multi-plane formats, like depth-stencil ones, can not be uploaded
+     */
     struct Tex2DInitData
     {
         const Tex2DSubInitData *subrscInitData = nullptr;
     };
 
+    /**
+     * @brief data of a box in one subrsc
+     *
+     * box is in texels, and its front and back are ignored. for block
+     *  compressed formats, left and top must be block-aligned, and right and
+     *  bottom must be block-aligned or on the edge of the subrsc.
+     *
+     * rowSize is the byte distance between rows of blocks. 0 for tightly
+     *  packed data
+     */
+    struct Tex2DRegionData
+    {
+        UINT        subrsc  = 0;
+        D3D12_BOX   box     = {};
+        const void *data    = nullptr;
+        size_t      rowSize = 0;
+    };
+
+    /**
+     * @brief records uploads on a worker thread. NOT thread-safe
+     *
+     * each context owns a persistently mapped staging ring and copy cmd lists,
+     *  so contexts on different threads copy data into staging memory and
+     *  record cmds without contention. submissions of all contexts and of the
+     *  uploader are serialized on the copy queue in the order they are made.
+     *
+     * contexts must be created and destroyed on the thread using the uploader,
+     *  and destroyed before it. upload destinations must be resident. they are
+     *  tracked by the residency manager in the next submit or collect of the
+     *  uploader.
+     */
+    class ThreadContext : public misc::uncopyable_t
+    {
+    public:
+
+        ~ThreadContext();
+
+        void uploadBufferData(
+            ComPtr<ID3D12Resource> dst,
+            const void            *data,
+            size_t                 byteSize,
+            D3D12_RESOURCE_STATES  afterState);
+
+        /**
+         * @brief upload into a range of a default heap buffer block. no
+         *  barrier is recorded
+         */
+        void uploadBufferData(
+            const BufferRange &dst,
+            const void        *data,
+            size_t             byteSize);
+
+        void uploadTex2DData(
+            ComPtr<ID3D12Resource> dst,
+            const Tex2DInitData   &initData,
+            D3D12_RESOURCE_STATES  afterState);
+
+        void uploadTex2DRegions(
+            ComPtr<ID3D12Resource> dst,
+            const Tex2DRegionData *regions,
+            size_t                 regionCount,
+            D3D12_RESOURCE_STATES  afterState);
+
+        /**
+         * @brief chunks are decompressed on the calling thread
+         */
+        void uploadCompressedBufferData(
+            ComPtr<ID3D12Resource> dst,
+            const ChunkedLZ4View  &src,
+            D3D12_RESOURCE_STATES  afterState);
+
+        /**
+         * @brief submit recorded uploads. returns fence value of the
+         *  submission, or of the last one if nothing is recorded
+         */
+        UINT64 submit();
+
+        /**
+         * @brief whether submission with given fence value is finished
+         */
+        bool isFinished(UINT64 fenceValue) const;
+
+        /**
+         * @brief reclaim finished staging space
+         */
+        void collect();
+
+        /**
+         * @brief submit recorded uploads and wait for all submissions
+         */
+        void waitForIdle();
+
+    private:
+
+        friend class ResourceUploader;
+
+        ThreadContext(
+            ResourceUploader &uploader,
+            size_t            ringCmdListCount,
+            UINT64            stagingRingSize);
+
+        ResourceUploader &uploader_;
+
+        std::unique_ptr<Recorder> recorder_;
+    };
+
     ResourceUploader(
         ComPtr<ID3D12Device>       device,
         ComPtr<ID3D12CommandQueue> copyQueue,
         ComPtr<ID3D12CommandQueue> graphicsQueue,
-        size_t                     ringCmdListCount);
+        size_t                     ringCmdListCount,
+        UINT64                     stagingRingSize = DEFAULT_STAGING_RING_SIZE);
 
     ResourceUploader(
         Window &window,
-        size_t  ringCmdListCount);
+        size_t  ringCmdListCount,
+        UINT64  stagingRingSize = DEFAULT_STAGING_RING_SIZE);
 
     ~ResourceUploader();
 
+    /**
+     * @brief upload into a default heap buffer in COMMON state
+     *
+     * dst is transitioned to afterState, which is its real state once the
+     *  upload is finished. pass COMMON to record no transition and rely on
+     *  implicit promotion instead
+     */
     void uploadBufferData(
         ComPtr<ID3D12Resource> dst,
         const void            *data,
@@ -59,6 +228,17 @@ public:
         const void           *data,
         D3D12_RESOURCE_STATES afterState);
 
+    /**
+     * @brief upload into a range of a default heap buffer block
+     *
+     * no barrier is recorded. the block is expected to be in COMMON state,
+     *  from which buffers are implicitly promoted to any read state
+     */
+    void uploadBufferData(
+        const BufferRange &dst,
+        const void        *data,
+        size_t             byteSize);
+
     void uploadTex2DData(
         ComPtr<ID3D12Resource>  dst,
         const Tex2DSubInitData &initData,
@@ -69,10 +249,137 @@ public:
         const Tex2DInitData   &initData,
         D3D12_RESOURCE_STATES  afterState);
 
+    /**
+     * @brief update a box of a subrsc. only bytes in the box are staged
+     *
+     * like other uploads, dst must be in COMMON state (e.g. left so by a
+     *  previous upload with COMMON afterState) and not used by gpu during the
+     *  copy
+     */
+    void uploadTex2DRegion(
+        ComPtr<ID3D12Resource> dst,
+        const Tex2DRegionData &region,
+        D3D12_RESOURCE_STATES  afterState);
+
+    /**
+     * @brief update many boxes with one CopyTextureRegion per box (or per
+     *  chunk of rows of large boxes) and at most one transition
+     */
+    void uploadTex2DRegions(
+        ComPtr<ID3D12Resource> dst,
+        const Tex2DRegionData *regions,
+        size_t                 regionCount,
+        D3D12_RESOURCE_STATES  afterState);
+
+    /**
+     * @brief upload data compressed by compressChunkedLZ4
+     *
+     * chunks are decompressed in parallel by decompression threads and
+     *  written straight into the staging ring. no decompressed copy of the
+     *  whole data is made
+     */
+    void uploadCompressedBufferData(
+        ComPtr<ID3D12Resource> dst,
+        const ChunkedLZ4View  &src,
+        D3D12_RESOURCE_STATES  afterState);
+
+    /**
+     * @brief upload compressed data into a range of a default heap buffer
+     *  block. no barrier is recorded
+     */
+    void uploadCompressedBufferData(
+        const BufferRange    &dst,
+        const ChunkedLZ4View &src);
+
+    /**
+     * @brief number of threads decompressing chunks. defaults to hardware
+     *  concurrency
+     */
+    void setDecompressionThreadCount(int threadCount);
+
+    /**
+     * @brief queue an upload. higher priority ones are recorded first
+     *
+     * data must be kept valid until the ticket is finished
+     */
+    UploadTicket uploadBufferDataAsync(
+        ComPtr<ID3D12Resource> dst,
+        const void            *data,
+        size_t                 byteSize,
+        D3D12_RESOURCE_STATES  afterState,
+        int                    priority = 0,
+        UploadCallback         callback = {});
+
+    /**
+     * @brief queue an upload. higher priority ones are recorded first
+     *
+     * subrsc data must be kept valid until the ticket is finished
+     */
+    UploadTicket uploadTex2DDataAsync(
+        ComPtr<ID3D12Resource> dst,
+        const Tex2DInitData   &initData,
+        D3D12_RESOURCE_STATES  afterState,
+        int                    priority = 0,
+        UploadCallback         callback = {});
+
+    /**
+     * @brief max bytes recorded by one 'processAsyncUploads' call. at least
+     *  one upload is recorded per call, so larger ones still make progress
+     */
+    void setAsyncBytesPerCall(UINT64 bytes) noexcept;
+
+    /**
+     * @brief record queued uploads within byte budget and submit them
+     *
+     * typically called once per frame. when recording an upload throws, the
+     *  upload is dropped and its ticket becomes finished without invoking its
+     *  callback. uploads recorded before it are still submitted
+     */
+    void processAsyncUploads();
+
+    bool isFinished(UploadTicket ticket) const noexcept;
+
+    size_t getQueuedAsyncUploadCount() const noexcept;
+
+    /**
+     * @brief track upload destinations with given manager, and make them
+     *  resident before submitting
+     *
+     * newly tracked destinations are pinned, i.e. never evicted, since the
+     *  uploader can not know which cmd lists reference them later. the owner
+     *  may 'unpin' one once and then 'use' it for each cmd list referencing
+     *  it. uploads pin their destination again until the copies are finished.
+     *
+     * must be called before any upload
+     */
+    void setResidencyManager(ResidencyManager *residencyMgr);
+
+    /**
+     * @brief counter of the upload rings used for staging, including those of
+     *  thread contexts. merge it with AllocationStats::addUploadCounter
+     */
+    const AllocationCounter &getStagingCounter() const noexcept;
+
+    /**
+     * @brief create a context for recording uploads on a worker thread
+     */
+    std::unique_ptr<ThreadContext> createThreadContext(
+        UINT64 stagingRingSize  = DEFAULT_THREAD_STAGING_RING_SIZE,
+        size_t ringCmdListCount = 2);
+
     void submit();
 
+    /**
+     * @brief reclaim finished staging space and invoke callbacks of finished
+     *  async uploads
+     */
     void collect();
 
+    /**
+     * @brief wait for all submitted uploads, including those of thread
+     *  contexts. queued async uploads that are not recorded yet are not waited
+     *  for
+     */
     void waitForIdle();
 
 private:
@@ -84,30 +391,120 @@ private:
     ComPtr<ID3D12Fence> copyToGraphicsFence_;
     ComPtr<ID3D12Fence> finishFence_;
 
+    // protects queue submissions, fence values and pendingResidencyRscs_
+    std::mutex submitMutex_;
+
     UINT64 nextExpectedCopyToGraphicsFenceValue_;
     UINT64 nextExpectedFinishFenceValue_;
 
-    struct RingCmdList
+    void initRecorder(
+        Recorder &recorder, size_t ringCmdListCount, UINT64 stagingRingSize);
+
+    void destroyRecorder(Recorder &recorder);
+
+    // returns offset in staging ring of recorder. submits its cmd lists and
+    // waits for its old submissions when the ring is full
+    UINT64 allocStaging(Recorder &recorder, UINT64 size, UINT64 alignment);
+
+    static UINT64 getMaxStagingChunkSize(const Recorder &recorder) noexcept;
+
+    void copyBufferData(
+        Recorder       &recorder,
+        ID3D12Resource *dst,
+        UINT64          dstOffset,
+        const void     *data,
+        UINT64          byteSize);
+
+    void copyTex2DData(
+        Recorder            &recorder,
+        ID3D12Resource      *dst,
+        const Tex2DInitData &initData);
+
+    void copyTex2DRegion(
+        Recorder                  &recorder,
+        ID3D12Resource            *dst,
+        const D3D12_RESOURCE_DESC &dstDesc,
+        const Tex2DRegionData     &region);
+
+    // decompress on decompression threads if 'parallel' is true
+    void copyCompressedBufferData(
+        Recorder             &recorder,
+        ID3D12Resource       *dst,
+        UINT64                dstOffset,
+        const ChunkedLZ4View &src,
+        bool                  parallel);
+
+    static void recordTransition(
+        Recorder             &recorder,
+        ID3D12Resource       *rsc,
+        D3D12_RESOURCE_STATES afterState);
+
+    // keep dst alive until its copies are finished
+    static void addUploadingRsc(
+        Recorder &recorder, ComPtr<ID3D12Resource> rsc);
+
+    // thread-safe with respect to other recorders. returns finish fence value
+    UINT64 submitRecorder(Recorder &recorder);
+
+    static void retireRecorder(Recorder &recorder, UINT64 completedFenceValue);
+
+    // dst is pinned in residency manager until a PinnedRsc of it is
+    // finished
+    void useResidency(ComPtr<ID3D12Resource> dst);
+
+    // track dsts submitted by thread contexts
+    void trackPendingResidency();
+
+    void unpinFinishedRscs(UINT64 completedFenceValue);
+
+    std::unique_ptr<Recorder> mainRecorder_;
+
+    AllocationCounter stagingCounter_;
+
+    struct PinnedRsc
     {
         UINT64 expectedFenceValue = 0;
-        SingleCommandList cmdList;
+        ComPtr<ID3D12Resource> rsc;
     };
 
-    std::vector<RingCmdList> copyCmdLists_;
-    std::vector<RingCmdList> graphicsCmdLists_;
-    size_t curCmdListIdx_;
+    // dsts submitted by thread contexts and not tracked yet
+    std::vector<PinnedRsc> pendingResidencyRscs_;
+
+    // dsts whose copies are submitted. used by the owning thread only
+    std::vector<PinnedRsc> pinnedRscs_;
 
-    bool isCurCmdListDirty_;
-    bool isCurGraphicsCmdListDirty_;
+    int decompressThreadCount_;
+    std::unique_ptr<thread::thread_group_t> decompressThreadGroup_;
 
-    struct UploadingRsc
+    // async uploads
+
+    struct AsyncUpload
+    {
+        UINT64 byteSize = 0;
+        std::function<void()> record;
+        UploadCallback callback;
+    };
+
+    struct InflightAsyncUpload
     {
         UINT64 expectedFenceValue = 0;
-        ComPtr<ID3D12Resource> upload;
-        ComPtr<ID3D12Resource> rsc;
+        UploadTicket ticket = 0;
+        UploadCallback callback;
     };
 
-    std::vector<UploadingRsc> uploadingRscs_;
+    UploadTicket queueAsyncUpload(int priority, AsyncUpload upload);
+
+    // (-priority, ticket) -> upload
+    std::map<std::pair<int, UploadTicket>, AsyncUpload> queuedAsyncUploads_;
+
+    std::deque<InflightAsyncUpload> inflightAsyncUploads_;
+
+    std::unordered_set<UploadTicket> unfinishedTickets_;
+
+    UploadTicket nextTicket_;
+    UINT64 asyncBytesPerCall_;
+
+    ResidencyManager *residencyMgr_;
 };
 
 AGZ_D3D12_END
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <agz/d3d12/sync/resourceUploader.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief content-addressed cache in front of a resource uploader
+ *
+ * source bytes are hashed with xxHash64 under two seeds. acquiring content
+ *  whose hashes, desc and afterState equal those of a cached entry returns
+ *  the existing rsc
+ *  without creating or uploading anything. otherwise a committed default
+ *  heap rsc is created and uploaded by the uploader. a hit may return a rsc
+ *  whose upload is not finished yet, which is ready together with the
+ *  uploads recorded before.
+ *
+ * entries are reference counted. each acquire must be paired with a release
+ *  of the returned rsc, after which the entry is dropped when no reference is
+ *  left. source bytes are not kept or compared, so content is identified by
+ *  the two 64-bit hashes only. accidental collisions are negligible, but
+ *  contents crafted to collide would share a rsc, so do not cache contents
+ *  from untrusted sources.
+ *
+ * NOT thread-safe.
+ */
+class UploadCache : public misc::uncopyable_t
+{
+public:
+
+    struct Stats
+    {
+        UINT64 hitCount   = 0;
+        UINT64 missCount  = 0;
+        UINT64 savedBytes = 0; // gpu memory of rscs returned by hits
+
+        size_t entryCount = 0;
+    };
+
+    UploadCache(ComPtr<ID3D12Device> device, ResourceUploader &uploader);
+
+    ComPtr<ID3D12Resource> acquireBuffer(
+        const void           *data,
+        size_t                byteSize,
+        D3D12_RESOURCE_STATES afterState,
+        D3D12_RESOURCE_FLAGS  flags = D3D12_RESOURCE_FLAG_NONE);
+
+    /**
+     * @brief initData contains DepthOrArraySize * MipLevels subrscs
+     */
+    ComPtr<ID3D12Resource> acquireTex2D(
+        const D3D12_RESOURCE_DESC             &desc,
+        const ResourceUploader::Tex2DInitData &initData,
+        D3D12_RESOURCE_STATES                  afterState);
+
+    ComPtr<ID3D12Resource> acquireTex2D(
+        const D3D12_RESOURCE_DESC                &desc,
+        const ResourceUploader::Tex2DSubInitData &initData,
+        D3D12_RESOURCE_STATES                     afterState);
+
+    /**
+     * @brief release a reference of rsc returned by acquire
+     *
+     * the cache stops holding the rsc when its last reference is released.
+     *  gpu work using it must still keep it alive
+     */
+    void release(ID3D12Resource *rsc);
+
+    Stats getStats() const noexcept;
+
+private:
+
+    struct ContentHash
+    {
+        uint64_t key   = 0; // key of hashToEntries_
+        uint64_t check = 0; // hashed with another seed
+    };
+
+    struct Entry
+    {
+        uint64_t               checkHash;
+        D3D12_RESOURCE_DESC    desc;
+        D3D12_RESOURCE_STATES  afterState;
+        ComPtr<ID3D12Resource> rsc;
+        UINT64                 byteSize;
+        size_t                 refCount;
+    };
+
+    // fill mip count & alignment left to d3d12 by desc
+    D3D12_RESOURCE_DESC resolveDesc(const D3D12_RESOURCE_DESC &desc) const;
+
+    // desc must be resolved
+    ContentHash hashTex2D(
+        const D3D12_RESOURCE_DESC             &desc,
+        const ResourceUploader::Tex2DInitData &initData) const;
+
+    // returns null when not found. increase its ref count otherwise
+    ComPtr<ID3D12Resource> acquireExisting(
+        const ContentHash         &hash,
+        const D3D12_RESOURCE_DESC &desc,
+        D3D12_RESOURCE_STATES      afterState);
+
+    ComPtr<ID3D12Resource> createEntry(
+        const ContentHash         &hash,
+        const D3D12_RESOURCE_DESC &desc,
+        D3D12_RESOURCE_STATES      afterState);
+
+    ComPtr<ID3D12Device> device_;
+    ResourceUploader    &uploader_;
+
+    std::unordered_map<uint64_t, std::vector<Entry>>  hashToEntries_;
+    std::unordered_map<ID3D12Resource *, ContentHash> rscToHash_;
+
+    Stats stats_;
+};
+
+AGZ_D3D12_END
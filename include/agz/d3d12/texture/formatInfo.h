@@ -0,0 +1,224 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <dxgiformat.h>
+
+#include <agz/d3d12/common.h>
+
+AGZ_D3D12_BEGIN
+
+/**
+ * @brief memory layout of a dxgi format
+ *
+ * texels are stored in blocks of blockWidth * blockHeight. uncompressed
+ *  formats have 1x1 blocks, block-compressed formats have 4x4 blocks and
+ *  packed formats like R8G8_B8G8 have 2x1 blocks.
+ *
+ * bytesPerBlock is 0 for UNKNOWN and planar video formats, whose planes have
+ *  different layouts.
+ */
+struct FormatInfo
+{
+    UINT bytesPerBlock = 0;
+    UINT blockWidth    = 1;
+    UINT blockHeight   = 1;
+    UINT planeCount    = 1;
+    bool isTypeless    = false;
+
+    constexpr bool isCompressed() const noexcept;
+
+    /**
+     * @brief bytes of a tightly packed row of blocks
+     */
+    constexpr UINT64 getRowSize(UINT width) const noexcept;
+
+    /**
+     * @brief number of block rows
+     */
+    constexpr UINT getRowCount(UINT height) const noexcept;
+};
+
+constexpr FormatInfo getFormatInfo(DXGI_FORMAT format) noexcept;
+
+constexpr bool isTypeless(DXGI_FORMAT format) noexcept;
+
+constexpr bool FormatInfo::isCompressed() const noexcept
+{
+    return blockWidth > 1 && blockHeight > 1;
+}
+
+constexpr UINT64 FormatInfo::getRowSize(UINT width) const noexcept
+{
+    return UINT64((width + blockWidth - 1) / blockWidth) * bytesPerBlock;
+}
+
+constexpr UINT FormatInfo::getRowCount(UINT height) const noexcept
+{
+    return (height + blockHeight - 1) / blockHeight;
+}
+
+namespace detail
+{
+
+    constexpr FormatInfo _makeFormatInfo(DXGI_FORMAT format) noexcept
+    {
+        // bytes per block, block width, block height, plane count, typeless
+        switch(format)
+        {
+        case DXGI_FORMAT_R32G32B32A32_TYPELESS:      return { 16, 1, 1, 1, true  };
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:         return { 16, 1, 1, 1, false };
+        case DXGI_FORMAT_R32G32B32A32_UINT:          return { 16, 1, 1, 1, false };
+        case DXGI_FORMAT_R32G32B32A32_SINT:          return { 16, 1, 1, 1, false };
+        case DXGI_FORMAT_R32G32B32_TYPELESS:         return { 12, 1, 1, 1, true  };
+        case DXGI_FORMAT_R32G32B32_FLOAT:            return { 12, 1, 1, 1, false };
+        case DXGI_FORMAT_R32G32B32_UINT:             return { 12, 1, 1, 1, false };
+        case DXGI_FORMAT_R32G32B32_SINT:             return { 12, 1, 1, 1, false };
+        case DXGI_FORMAT_R16G16B16A16_TYPELESS:      return { 8,  1, 1, 1, true  };
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:         return { 8,  1, 1, 1, false };
+        case DXGI_FORMAT_R16G16B16A16_UNORM:         return { 8,  1, 1, 1, false };
+        case DXGI_FORMAT_R16G16B16A16_UINT:          return { 8,  1, 1, 1, false };
+        case DXGI_FORMAT_R16G16B16A16_SNORM:         return { 8,  1, 1, 1, false };
+        case DXGI_FORMAT_R16G16B16A16_SINT:          return { 8,  1, 1, 1, false };
+        case DXGI_FORMAT_R32G32_TYPELESS:            return { 8,  1, 1, 1, true  };
+        case DXGI_FORMAT_R32G32_FLOAT:               return { 8,  1, 1, 1, false };
+        case DXGI_FORMAT_R32G32_UINT:                return { 8,  1, 1, 1, false };
+        case DXGI_FORMAT_R32G32_SINT:                return { 8,  1, 1, 1, false };
+        case DXGI_FORMAT_R32G8X24_TYPELESS:          return { 8,  1, 1, 2, true  };
+        case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:       return { 8,  1, 1, 2, false };
+        case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:   return { 8,  1, 1, 2, true  };
+        case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:    return { 8,  1, 1, 2, true  };
+        case DXGI_FORMAT_R10G10B10A2_TYPELESS:       return { 4,  1, 1, 1, true  };
+        case DXGI_FORMAT_R10G10B10A2_UNORM:          return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R10G10B10A2_UINT:           return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R11G11B10_FLOAT:            return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R8G8B8A8_TYPELESS:          return { 4,  1, 1, 1, true  };
+        case DXGI_FORMAT_R8G8B8A8_UNORM:             return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:        return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R8G8B8A8_UINT:              return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R8G8B8A8_SNORM:             return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R8G8B8A8_SINT:              return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R16G16_TYPELESS:            return { 4,  1, 1, 1, true  };
+        case DXGI_FORMAT_R16G16_FLOAT:               return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R16G16_UNORM:               return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R16G16_UINT:                return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R16G16_SNORM:               return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R16G16_SINT:                return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R32_TYPELESS:               return { 4,  1, 1, 1, true  };
+        case DXGI_FORMAT_D32_FLOAT:                  return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R32_FLOAT:                  return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R32_UINT:                   return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R32_SINT:                   return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R24G8_TYPELESS:             return { 4,  1, 1, 2, true  };
+        case DXGI_FORMAT_D24_UNORM_S8_UINT:          return { 4,  1, 1, 2, false };
+        case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:      return { 4,  1, 1, 2, true  };
+        case DXGI_FORMAT_X24_TYPELESS_G8_UINT:       return { 4,  1, 1, 2, true  };
+        case DXGI_FORMAT_R8G8_TYPELESS:              return { 2,  1, 1, 1, true  };
+        case DXGI_FORMAT_R8G8_UNORM:                 return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_R8G8_UINT:                  return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_R8G8_SNORM:                 return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_R8G8_SINT:                  return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_R16_TYPELESS:               return { 2,  1, 1, 1, true  };
+        case DXGI_FORMAT_R16_FLOAT:                  return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_D16_UNORM:                  return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_R16_UNORM:                  return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_R16_UINT:                   return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_R16_SNORM:                  return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_R16_SINT:                   return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_R8_TYPELESS:                return { 1,  1, 1, 1, true  };
+        case DXGI_FORMAT_R8_UNORM:                   return { 1,  1, 1, 1, false };
+        case DXGI_FORMAT_R8_UINT:                    return { 1,  1, 1, 1, false };
+        case DXGI_FORMAT_R8_SNORM:                   return { 1,  1, 1, 1, false };
+        case DXGI_FORMAT_R8_SINT:                    return { 1,  1, 1, 1, false };
+        case DXGI_FORMAT_A8_UNORM:                   return { 1,  1, 1, 1, false };
+        case DXGI_FORMAT_R1_UNORM:                   return { 1,  8, 1, 1, false };
+        case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:         return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R8G8_B8G8_UNORM:            return { 4,  2, 1, 1, false };
+        case DXGI_FORMAT_G8R8_G8B8_UNORM:            return { 4,  2, 1, 1, false };
+        case DXGI_FORMAT_BC1_TYPELESS:               return { 8,  4, 4, 1, true  };
+        case DXGI_FORMAT_BC1_UNORM:                  return { 8,  4, 4, 1, false };
+        case DXGI_FORMAT_BC1_UNORM_SRGB:             return { 8,  4, 4, 1, false };
+        case DXGI_FORMAT_BC2_TYPELESS:               return { 16, 4, 4, 1, true  };
+        case DXGI_FORMAT_BC2_UNORM:                  return { 16, 4, 4, 1, false };
+        case DXGI_FORMAT_BC2_UNORM_SRGB:             return { 16, 4, 4, 1, false };
+        case DXGI_FORMAT_BC3_TYPELESS:               return { 16, 4, 4, 1, true  };
+        case DXGI_FORMAT_BC3_UNORM:                  return { 16, 4, 4, 1, false };
+        case DXGI_FORMAT_BC3_UNORM_SRGB:             return { 16, 4, 4, 1, false };
+        case DXGI_FORMAT_BC4_TYPELESS:               return { 8,  4, 4, 1, true  };
+        case DXGI_FORMAT_BC4_UNORM:                  return { 8,  4, 4, 1, false };
+        case DXGI_FORMAT_BC4_SNORM:                  return { 8,  4, 4, 1, false };
+        case DXGI_FORMAT_BC5_TYPELESS:               return { 16, 4, 4, 1, true  };
+        case DXGI_FORMAT_BC5_UNORM:                  return { 16, 4, 4, 1, false };
+        case DXGI_FORMAT_BC5_SNORM:                  return { 16, 4, 4, 1, false };
+        case DXGI_FORMAT_B5G6R5_UNORM:               return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_B5G5R5A1_UNORM:             return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_B8G8R8A8_UNORM:             return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_B8G8R8X8_UNORM:             return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM: return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_B8G8R8A8_TYPELESS:          return { 4,  1, 1, 1, true  };
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:        return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_B8G8R8X8_TYPELESS:          return { 4,  1, 1, 1, true  };
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:        return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_BC6H_TYPELESS:              return { 16, 4, 4, 1, true  };
+        case DXGI_FORMAT_BC6H_UF16:                  return { 16, 4, 4, 1, false };
+        case DXGI_FORMAT_BC6H_SF16:                  return { 16, 4, 4, 1, false };
+        case DXGI_FORMAT_BC7_TYPELESS:               return { 16, 4, 4, 1, true  };
+        case DXGI_FORMAT_BC7_UNORM:                  return { 16, 4, 4, 1, false };
+        case DXGI_FORMAT_BC7_UNORM_SRGB:             return { 16, 4, 4, 1, false };
+        case DXGI_FORMAT_AYUV:                       return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_Y410:                       return { 4,  1, 1, 1, false };
+        case DXGI_FORMAT_Y416:                       return { 8,  1, 1, 1, false };
+        case DXGI_FORMAT_NV12:                       return { 0,  1, 1, 2, false };
+        case DXGI_FORMAT_P010:                       return { 0,  1, 1, 2, false };
+        case DXGI_FORMAT_P016:                       return { 0,  1, 1, 2, false };
+        case DXGI_FORMAT_420_OPAQUE:                 return { 0,  1, 1, 2, false };
+        case DXGI_FORMAT_YUY2:                       return { 4,  2, 1, 1, false };
+        case DXGI_FORMAT_Y210:                       return { 8,  2, 1, 1, false };
+        case DXGI_FORMAT_Y216:                       return { 8,  2, 1, 1, false };
+        case DXGI_FORMAT_NV11:                       return { 0,  1, 1, 2, false };
+        case DXGI_FORMAT_AI44:                       return { 1,  1, 1, 1, false };
+        case DXGI_FORMAT_IA44:                       return { 1,  1, 1, 1, false };
+        case DXGI_FORMAT_P8:                         return { 1,  1, 1, 1, false };
+        case DXGI_FORMAT_A8P8:                       return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_B4G4R4A4_UNORM:             return { 2,  1, 1, 1, false };
+        case DXGI_FORMAT_P208:                       return { 0,  1, 1, 2, false };
+        case DXGI_FORMAT_V208:                       return { 0,  1, 1, 3, false };
+        case DXGI_FORMAT_V408:                       return { 0,  1, 1, 3, false };
+        default:                                     return {};
+        }
+    }
+
+    // all formats up to DXGI_FORMAT_V408
+    constexpr size_t _FORMAT_TABLE_SIZE = DXGI_FORMAT_V408 + 1;
+
+    constexpr std::array<FormatInfo, _FORMAT_TABLE_SIZE> _makeFormatTable() noexcept
+    {
+        std::array<FormatInfo, _FORMAT_TABLE_SIZE> ret = {};
+        for(size_t i = 0; i < _FORMAT_TABLE_SIZE; ++i)
+            ret[i] = _makeFormatInfo(static_cast<DXGI_FORMAT>(i));
+        return ret;
+    }
+
+    inline constexpr auto _FORMAT_TABLE = _makeFormatTable();
+
+} // namespace detail
+
+constexpr FormatInfo getFormatInfo(DXGI_FORMAT format) noexcept
+{
+    const size_t idx = static_cast<size_t>(format);
+    return idx < detail::_FORMAT_TABLE_SIZE ?
+           detail::_FORMAT_TABLE[idx] : FormatInfo{};
+}
+
+constexpr bool isTypeless(DXGI_FORMAT format) noexcept
+{
+    return getFormatInfo(format).isTypeless;
+}
+
+static_assert(getFormatInfo(DXGI_FORMAT_BC1_UNORM).bytesPerBlock == 8);
+static_assert(getFormatInfo(DXGI_FORMAT_BC7_UNORM).getRowSize(13) == 64);
+static_assert(getFormatInfo(DXGI_FORMAT_R16G16B16A16_FLOAT).getRowSize(3) == 24);
+static_assert(isTypeless(DXGI_FORMAT_R24G8_TYPELESS));
+
+AGZ_D3D12_END
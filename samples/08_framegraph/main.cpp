@@ -40,7 +40,12 @@ VSOutput main(VSInput input)
 )___";
 
 const char *GBUFFER_PIXEL_SHADER = R"___(
-Texture2D<float4> Albedo        : register(t0);
+cbuffer Material : register(b1)
+{
+    uint AlbedoIndex;
+};
+
+Texture2D<float4> Textures[]    : register(t0);
 SamplerState      LinearSampler : register(s0);
 
 struct PSInput
@@ -63,7 +68,7 @@ PSOutput main(PSInput input)
     PSOutput output = (PSOutput)0;
     output.position = float4(input.worldPosition, 1);
     output.normal   = float4(normalize(input.worldNormal), 0);
-    output.color    = Albedo.Sample(LinearSampler, input.uv);
+    output.color    = Textures[AlbedoIndex].Sample(LinearSampler, input.uv);
     return output;
 }
 )___";
@@ -154,16 +159,22 @@ void run()
     dsvHeap.initialize(
         device, 100, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, false);
 
+    // bindless textures
+
+    BindlessTable textures;
+    textures.initialize(gpuHeap.allocRange(32));
+
     // meshes
 
     ResourceUploader uploader(window, 1);
+    UploadCache uploadCache(window.getDevice(), uploader);
 
     std::vector<Mesh> meshes(2);
     meshes[0].loadFromFile(
-        window, uploader, gpuHeap.getRootSubheap(),
+        window, uploader, uploadCache, textures,
         "./asset/03_cube.obj", "./asset/03_texture.png");
     meshes[1].loadFromFile(
-        window, uploader, gpuHeap.getRootSubheap(),
+        window, uploader, uploadCache, textures,
         "./asset/03_cube.obj", "./asset/03_texture.png");
 
     uploader.waitForIdle();
@@ -197,10 +208,11 @@ void run()
     {
         D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT,
         fg::ConstantBufferView{ D3D12_SHADER_VISIBILITY_VERTEX, fg::s0b0 },
+        fg::ImmediateConstants{ D3D12_SHADER_VISIBILITY_PIXEL, fg::s0b1, 1 },
         fg::DescriptorTable
         {
             D3D12_SHADER_VISIBILITY_PIXEL,
-            fg::SRVRange{ fg::s0t0 }
+            fg::SRVRange{ fg::s0t0, fg::UNBOUNDED_RANGE }
         },
         fg::StaticSampler
         {
@@ -251,7 +263,7 @@ void run()
     auto gBufferPipeline = fg::GraphicsPipelineState{
         gBufferRootSignature,
         fg::VertexShader{ GBUFFER_VERTEX_SHADER, "vs_5_0" },
-        fg::PixelShader{ GBUFFER_PIXEL_SHADER, "ps_5_0" },
+        fg::PixelShader{ GBUFFER_PIXEL_SHADER, "ps_5_1" },
         fg::InputLayout(gBufferInputElems),
         fg::PipelineRTVFormats{
             DXGI_FORMAT_R32G32B32A32_FLOAT,
@@ -329,6 +341,9 @@ void run()
                 cmdList->IASetPrimitiveTopology(
                     D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
+                cmdList->SetGraphicsRootDescriptorTable(
+                    2, textures.getGPUHandle());
+
                 for(auto &m : meshes)
                 {
                     m.draw(
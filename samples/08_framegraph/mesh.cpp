@@ -1,16 +1,25 @@
+#include <d3dx12.h>
+
 #include <agz/utility/image.h>
 #include <agz/utility/mesh.h>
 
 #include "./mesh.h"
 
+Mesh::~Mesh()
+{
+    if(albedo_)
+        uploadCache_->release(albedo_.Get());
+}
+
 void Mesh::loadFromFile(
     const Window      &window,
     ResourceUploader  &uploader,
-    DescriptorSubHeap &descHeap,
+    UploadCache       &uploadCache,
+    BindlessTable     &textures,
     const std::string &objFilename,
     const std::string &albedoFilename)
 {
-    albedoDescTable_ = descHeap.allocRange(1);
+    albedoIdx_ = textures.alloc();
 
     std::vector<ComPtr<ID3D12Resource>> ret;
 
@@ -24,17 +33,16 @@ void Mesh::loadFromFile(
             "failed to load image data from " + albedoFilename);
     }
 
-    albedo_.initialize(
-        window.getDevice(),
-        DXGI_FORMAT_R8G8B8A8_UNORM,
-        imgData.width(), imgData.height(),
-        1, 1, 1, 0, {}, {});
-
-    uploader.uploadTex2DData(
-        albedo_, ResourceUploader::Tex2DSubInitData{ imgData.raw_data() },
+    uploadCache_ = &uploadCache;
+    albedo_ = uploadCache.acquireTex2D(
+        CD3DX12_RESOURCE_DESC::Tex2D(
+            DXGI_FORMAT_R8G8B8A8_UNORM,
+            imgData.width(), imgData.height(), 1, 1),
+        ResourceUploader::Tex2DSubInitData{ imgData.raw_data() },
         D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
-    albedo_.createSRV(albedoDescTable_[0]);
+    window.getDevice()->CreateShaderResourceView(
+        albedo_.Get(), nullptr, textures[albedoIdx_]);
     
     // constant buffer
     
@@ -55,9 +63,11 @@ void Mesh::loadFromFile(
 
     vertexBuffer_.initializeDefault(window.getDevice(), vertexData.size(), {});
 
+    // left in COMMON and implicitly promoted when bound, so loading meshes
+    // records no graphics work
+
     uploader.uploadBufferData(
-        vertexBuffer_, vertexData.data(),
-        D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+        vertexBuffer_, vertexData.data(), D3D12_RESOURCE_STATE_COMMON);
 }
 
 void Mesh::setWorldTransform(const Mat4 &world) noexcept
@@ -76,8 +86,7 @@ void Mesh::draw(
     cmdList->SetGraphicsRootConstantBufferView(
         0, vsTransform_.getGpuVirtualAddress(imageIndex));
 
-    cmdList->SetGraphicsRootDescriptorTable(
-        1, albedoDescTable_[0].getGPUHandle());
+    cmdList->SetGraphicsRoot32BitConstant(1, albedoIdx_, 0);
 
     const auto vertexBufferView = vertexBuffer_.getView();
     cmdList->IASetVertexBuffers(0, 1, &vertexBufferView);
@@ -23,10 +23,25 @@ public:
         size_t        vertexCount;
     };
 
+    Mesh() = default;
+
+    // the destructor releases a reference of uploadCache, which must not be
+    // released twice by copies
+    Mesh(const Mesh &) = delete;
+
+    Mesh &operator=(const Mesh &) = delete;
+
+    ~Mesh();
+
+    /**
+     * @brief albedo texture is shared with meshes loaded with the same
+     *  content through uploadCache
+     */
     void loadFromFile(
         const Window      &window,
         ResourceUploader  &uploader,
-        DescriptorSubHeap &descHeap,
+        UploadCache       &uploadCache,
+        BindlessTable     &textures,
         const std::string &objFilename,
         const std::string &albedoFilename);
 
@@ -45,8 +60,9 @@ private:
         Mat4 world;
     };
 
-    Texture2D albedo_;
-    DescriptorRange albedoDescTable_;
+    UploadCache           *uploadCache_ = nullptr;
+    ComPtr<ID3D12Resource> albedo_;
+    BindlessTable::Index albedoIdx_ = 0;
 
     Mat4 world_;
     mutable ConstantBuffer<VSTransform> vsTransform_;
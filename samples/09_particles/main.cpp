@@ -57,12 +57,18 @@ void run()
     {
         ComPtr<ID3D12Resource> attractors;
         int attractorCnt = 1;
+
+        ResourceUploader::UploadTicket ticket = 0;
     };
 
     std::vector<MeshRecord> meshes;
     int curMeshIdx = 0;
     bool autoSwitchMesh = true;
 
+    // index of mesh set to particle system. -1 before the first upload is
+    // finished
+    int appliedMeshIdx = -1;
+
     auto loadMesh = [&](const char *filename)
     {
         AttractorMesh mesh;
@@ -70,7 +76,7 @@ void run()
 
         meshes.emplace_back();
         meshes.back().attractors = mesh.generateAttractorData(
-            device, uploader, MAX_ATTRACTOR_CNT);
+            device, uploader, MAX_ATTRACTOR_CNT, meshes.back().ticket);
         meshes.back().attractorCnt = 20000;
     };
 
@@ -86,9 +92,6 @@ void run()
     for(auto m : meshNameList)
         loadMesh(m);
 
-    particleSys.setMesh(
-        meshes[curMeshIdx].attractors, meshes[curMeshIdx].attractorCnt);
-
     // framegraph
 
     fg::FrameGraph graph(
@@ -124,10 +127,6 @@ void run()
         {
             modelSwitchCnter = 0;
             curMeshIdx = (curMeshIdx + 1) % static_cast<int>(meshes.size());
-
-            particleSys.setMesh(
-                meshes[curMeshIdx].attractors,
-                meshes[curMeshIdx].attractorCnt);
         }
 
         if(window.getKeyboard()->isDown(KEY_F1))
@@ -142,7 +141,7 @@ void run()
 
                 if(ImGui::SliderInt(
                     "Attractor Count", &meshes[curMeshIdx].attractorCnt,
-                    1, MAX_ATTRACTOR_CNT))
+                    1, MAX_ATTRACTOR_CNT) && appliedMeshIdx == curMeshIdx)
                 {
                     particleSys.setMesh(
                         meshes[curMeshIdx].attractors,
@@ -161,9 +160,6 @@ void run()
                     static_cast<int>(agz::array_size(meshNameList))))
                 {
                     modelSwitchCnter = 0;
-                    particleSys.setMesh(
-                        meshes[curMeshIdx].attractors,
-                        meshes[curMeshIdx].attractorCnt);
                 }
 
                 ImGui::Checkbox("Auto Switch Mesh", &autoSwitchMesh);
@@ -217,6 +213,20 @@ void run()
             ImGui::End();
         }
 
+        // meshes are switched to once their attractors are uploaded
+
+        uploader.processAsyncUploads();
+        uploader.collect();
+
+        if(appliedMeshIdx != curMeshIdx &&
+           uploader.isFinished(meshes[curMeshIdx].ticket))
+        {
+            appliedMeshIdx = curMeshIdx;
+            particleSys.setMesh(
+                meshes[curMeshIdx].attractors,
+                meshes[curMeshIdx].attractorCnt);
+        }
+
         frameFence.startFrame(window.getCurrentImageIndex());
 
         fg::ResourceIndex renderTargetIdx;
@@ -228,10 +238,13 @@ void run()
             D3D12_RESOURCE_STATE_PRESENT,
             D3D12_RESOURCE_STATE_PRESENT);
 
-        particleSys.initPasses(
-            window.getImageWidth(),
-            window.getImageHeight(),
-            graph, renderTargetIdx);
+        if(appliedMeshIdx >= 0)
+        {
+            particleSys.initPasses(
+                window.getImageWidth(),
+                window.getImageHeight(),
+                graph, renderTargetIdx);
+        }
 
         graph.addGraphicsPass(
             [&](ID3D12GraphicsCommandList *cmdList,
@@ -276,9 +289,12 @@ void run()
             window.getImageWOverH(),
             0.01f, 100.0f);
 
-        particleSys.update(
-            window.getCurrentImageIndex(),
-            0.0016f, view * proj, eye);
+        if(appliedMeshIdx >= 0)
+        {
+            particleSys.update(
+                window.getCurrentImageIndex(),
+                0.0016f, view * proj, eye);
+        }
 
         graph.setExternalRsc(renderTargetIdx, window.getCurrentImage());
         graph.execute();
@@ -67,14 +67,16 @@ void AttractorMesh::sampleSurface(size_t samplesCnt, Vec3 *output) const
 ComPtr<ID3D12Resource> AttractorMesh::generateAttractorData(
     ID3D12Device *device,
     ResourceUploader &uploader,
-    uint32_t attractorCount) const
+    uint32_t attractorCount,
+    ResourceUploader::UploadTicket &ticket) const
 {
     std::vector<Vec3> attractorPositions(attractorCount);
     sampleSurface(attractorCount, attractorPositions.data());
 
-    std::vector<AttractorData> attractors(attractorCount);
-    for(size_t i = 0; i < attractors.size(); ++i)
-        attractors[i].position = attractorPositions[i];
+    auto attractors =
+        std::make_shared<std::vector<AttractorData>>(attractorCount);
+    for(size_t i = 0; i < attractors->size(); ++i)
+        (*attractors)[i].position = attractorPositions[i];
 
     const size_t bufSize = attractorCount * sizeof(AttractorData);
 
@@ -86,13 +88,13 @@ ComPtr<ID3D12Resource> AttractorMesh::generateAttractorData(
         D3D12_RESOURCE_STATE_COMMON, nullptr,
         IID_PPV_ARGS(attractorsData.GetAddressOf()));
 
-    // upload data
+    // upload data. the callback holds the source data until the upload is
+    // finished
 
-    uploader.uploadBufferData(
-        attractorsData, attractors.data(), bufSize,
-        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-
-    uploader.waitForIdle();
+    ticket = uploader.uploadBufferDataAsync(
+        attractorsData, attractors->data(), bufSize,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+        0, [attractors] { });
 
     return attractorsData;
 }
@@ -20,10 +20,13 @@ public:
 
     void sampleSurface(size_t samplesCnt, Vec3 *output) const;
 
+    // the buffer is uploaded asynchronously and can be used after ticket is
+    // finished. see ResourceUploader::processAsyncUploads
     ComPtr<ID3D12Resource> generateAttractorData(
         ID3D12Device *device,
         ResourceUploader &uploader,
-        uint32_t attractorCount) const;
+        uint32_t attractorCount,
+        ResourceUploader::UploadTicket &ticket) const;
 
 private:
 
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cassert>
+
+#include <agz/d3d12/imgui/imgui.h>
+#include <agz/d3d12/memory/allocationStats.h>
+
+AGZ_D3D12_BEGIN
+
+namespace
+{
+    const char *HEAP_NAMES[] = { "default", "upload", "readback" };
+
+    void appendField(
+        std::string &json, const char *name, UINT64 value, bool last = false)
+    {
+        json += "\"";
+        json += name;
+        json += "\":";
+        json += std::to_string(value);
+        if(!last)
+            json += ",";
+    }
+
+    void appendHeapStats(std::string &json, const HeapStats &heap)
+    {
+        json += "{";
+        appendField(json, "blocks",         heap.blockCount);
+        appendField(json, "allocations",    heap.allocationCount);
+        appendField(json, "unusedRanges",   heap.unusedRangeCount);
+        appendField(json, "usedBytes",      heap.usedBytes);
+        appendField(json, "unusedBytes",    heap.unusedBytes);
+        appendField(json, "maxUnusedRange", heap.maxUnusedRange);
+        json += "\"fragmentation\":" + std::to_string(heap.getFragmentation());
+        json += "}";
+    }
+
+    void appendCounter(std::string &json, const AllocationCounter &counter)
+    {
+        json += "{";
+        appendField(json, "liveBytes",  counter.liveBytes);
+        appendField(json, "liveCount",  counter.liveCount);
+        appendField(json, "peakBytes",  counter.peakBytes);
+        appendField(json, "peakCount",  counter.peakCount);
+        appendField(json, "allocCount", counter.allocCount, true);
+        json += "}";
+    }
+
+    void showHeapStatsRow(const char *name, const HeapStats &heap)
+    {
+        ImGui::Text(
+            "%-8s blocks %3u allocs %5u used %8.2f MB unused %8.2f MB frag %.2f",
+            name, heap.blockCount, heap.allocationCount,
+            heap.usedBytes / (1024.0 * 1024.0),
+            heap.unusedBytes / (1024.0 * 1024.0),
+            heap.getFragmentation());
+    }
+
+} // namespace anonymous
+
+const char *getAllocationCategoryName(AllocationCategory category) noexcept
+{
+    switch(category)
+    {
+    case AllocationCategory::RenderTarget:    return "renderTarget";
+    case AllocationCategory::DepthStencil:    return "depthStencil";
+    case AllocationCategory::UnorderedAccess: return "unorderedAccess";
+    case AllocationCategory::Buffer:          return "buffer";
+    case AllocationCategory::Texture:         return "texture";
+    case AllocationCategory::Upload:          return "upload";
+    default:                                  return "unknown";
+    }
+}
+
+AllocationCategory getAllocationCategory(
+    const D3D12_RESOURCE_DESC &desc, D3D12_HEAP_TYPE heapType) noexcept
+{
+    if(heapType != D3D12_HEAP_TYPE_DEFAULT)
+        return AllocationCategory::Upload;
+    if(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET)
+        return AllocationCategory::RenderTarget;
+    if(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)
+        return AllocationCategory::DepthStencil;
+    if(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS)
+        return AllocationCategory::UnorderedAccess;
+    if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        return AllocationCategory::Buffer;
+    return AllocationCategory::Texture;
+}
+
+void AllocationCounter::onAlloc(UINT64 bytes) noexcept
+{
+    liveBytes += bytes;
+    ++liveCount;
+    ++allocCount;
+
+    peakBytes = (std::max)(peakBytes, liveBytes);
+    peakCount = (std::max)(peakCount, liveCount);
+}
+
+void AllocationCounter::onFree(UINT64 bytes) noexcept
+{
+    assert(liveCount && liveBytes >= bytes);
+    liveBytes -= bytes;
+    --liveCount;
+}
+
+void AllocationCounter::merge(const AllocationCounter &other) noexcept
+{
+    liveBytes  += other.liveBytes;
+    liveCount  += other.liveCount;
+    peakBytes  += other.peakBytes;
+    peakCount  += other.peakCount;
+    allocCount += other.allocCount;
+}
+
+float HeapStats::getFragmentation() const noexcept
+{
+    if(!unusedBytes)
+        return 0;
+    return 1 - static_cast<float>(
+        static_cast<double>(maxUnusedRange) / unusedBytes);
+}
+
+AllocationCounter &AllocationStats::operator[](
+    AllocationCategory category) noexcept
+{
+    return categories[static_cast<int>(category)];
+}
+
+const AllocationCounter &AllocationStats::operator[](
+    AllocationCategory category) const noexcept
+{
+    return categories[static_cast<int>(category)];
+}
+
+AllocationStats &AllocationStats::addUploadCounter(
+    const AllocationCounter &counter) noexcept
+{
+    (*this)[AllocationCategory::Upload].merge(counter);
+    return *this;
+}
+
+std::string AllocationStats::toJSON() const
+{
+    std::string json = "{";
+    appendField(json, "frame",       frame);
+    appendField(json, "pooledBytes", pooledBytes);
+
+    json += "\"total\":";
+    appendHeapStats(json, total);
+
+    json += ",\"heaps\":{";
+    for(int i = 0; i < 3; ++i)
+    {
+        json += "\"" + std::string(HEAP_NAMES[i]) + "\":";
+        appendHeapStats(json, heaps[i]);
+        if(i != 2)
+            json += ",";
+    }
+
+    json += "},\"categories\":{";
+    for(int i = 0; i < ALLOCATION_CATEGORY_COUNT; ++i)
+    {
+        json += "\"";
+        json += getAllocationCategoryName(static_cast<AllocationCategory>(i));
+        json += "\":";
+        appendCounter(json, categories[i]);
+        if(i != ALLOCATION_CATEGORY_COUNT - 1)
+            json += ",";
+    }
+
+    json += "}}";
+    return json;
+}
+
+void showAllocationStatsWindow(const AllocationStats &stats, bool *open)
+{
+    if(!ImGui::Begin("allocation stats", open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("frame %llu", static_cast<unsigned long long>(stats.frame));
+    ImGui::Text("pooled %.2f MB", stats.pooledBytes / (1024.0 * 1024.0));
+
+    if(ImGui::CollapsingHeader("heaps", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        showHeapStatsRow("total", stats.total);
+        for(int i = 0; i < 3; ++i)
+            showHeapStatsRow(HEAP_NAMES[i], stats.heaps[i]);
+    }
+
+    if(ImGui::CollapsingHeader("categories", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        for(int i = 0; i < ALLOCATION_CATEGORY_COUNT; ++i)
+        {
+            const auto &c = stats.categories[i];
+            ImGui::Text(
+                "%-16s live %8.2f MB (%5llu) peak %8.2f MB (%5llu)",
+                getAllocationCategoryName(static_cast<AllocationCategory>(i)),
+                c.liveBytes / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(c.liveCount),
+                c.peakBytes / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(c.peakCount));
+        }
+    }
+
+    ImGui::End();
+}
+
+AGZ_D3D12_END
@@ -0,0 +1,166 @@
+#include <d3dx12.h>
+
+#include <agz/d3d12/buffer/bufferSuballocator.h>
+
+AGZ_D3D12_BEGIN
+
+namespace
+{
+    D3D12_RESOURCE_STATES getHeapInitialState(D3D12_HEAP_TYPE heapType)
+    {
+        switch(heapType)
+        {
+        case D3D12_HEAP_TYPE_UPLOAD:
+            return D3D12_RESOURCE_STATE_GENERIC_READ;
+        case D3D12_HEAP_TYPE_READBACK:
+            return D3D12_RESOURCE_STATE_COPY_DEST;
+        case D3D12_HEAP_TYPE_DEFAULT:
+            return D3D12_RESOURCE_STATE_COMMON;
+        default:
+            throw D3D12LabException(
+                "buffer suballocator: unsupported heap type");
+        }
+    }
+}
+
+BufferSuballocator::BufferSuballocator(
+    ComPtr<ID3D12Device> device,
+    D3D12_HEAP_TYPE      heapType,
+    D3D12_RESOURCE_FLAGS flags,
+    UINT64               blockSize,
+    UINT64               minClassSize,
+    UINT64               maxClassSize)
+    : device_(std::move(device)),
+      heapType_(heapType),
+      flags_(flags),
+      initState_(getHeapInitialState(heapType)),
+      allocator_(
+          blockSize,
+          (std::max<UINT64>)(
+              minClassSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT),
+          maxClassSize)
+{
+
+}
+
+BufferSuballocator::~BufferSuballocator()
+{
+    for(auto &b : blocks_)
+    {
+        if(b.mappedData)
+            b.rsc->Unmap(0, nullptr);
+    }
+
+    for(auto &d : dedicatedRscs_)
+    {
+        if(heapType_ != D3D12_HEAP_TYPE_DEFAULT)
+            d.second->Unmap(0, nullptr);
+    }
+}
+
+BufferRange BufferSuballocator::alloc(UINT64 size)
+{
+    BufferRange ret;
+
+    if(!allocator_.isSuballocatable(size))
+    {
+        auto block = createBuffer(size);
+
+        ret.resource   = block.rsc.Get();
+        ret.offset     = 0;
+        ret.size       = size;
+        ret.mappedData = block.mappedData;
+        ret.dedicated  = true;
+
+        dedicatedRscs_[ret.resource] = std::move(block.rsc);
+        return ret;
+    }
+
+    auto allocation = allocator_.alloc(size);
+    if(!allocation)
+    {
+        blocks_.push_back(createBuffer(allocator_.getBlockSize()));
+        allocator_.addBlock();
+
+        allocation = allocator_.alloc(size);
+        assert(allocation);
+    }
+
+    auto &block = blocks_[allocation->block];
+
+    ret.resource   = block.rsc.Get();
+    ret.offset     = allocation->offset;
+    ret.size       = allocation->size;
+    ret.mappedData = block.mappedData ?
+                     block.mappedData + allocation->offset : nullptr;
+    ret.dedicated  = false;
+    ret.allocation = *allocation;
+
+    return ret;
+}
+
+void BufferSuballocator::free(const BufferRange &range)
+{
+    if(range.dedicated)
+    {
+        const auto it = dedicatedRscs_.find(range.resource);
+        assert(it != dedicatedRscs_.end());
+
+        if(heapType_ != D3D12_HEAP_TYPE_DEFAULT)
+            it->second->Unmap(0, nullptr);
+
+        counter_.onFree(range.size);
+        dedicatedRscs_.erase(it);
+        return;
+    }
+
+    allocator_.free(range.allocation);
+}
+
+D3D12_HEAP_TYPE BufferSuballocator::getHeapType() const noexcept
+{
+    return heapType_;
+}
+
+D3D12_RESOURCE_STATES BufferSuballocator::getInitialState() const noexcept
+{
+    return initState_;
+}
+
+const AllocationCounter &BufferSuballocator::getCounter() const noexcept
+{
+    return counter_;
+}
+
+BufferSuballocator::BlockRsc BufferSuballocator::createBuffer(UINT64 size)
+{
+    BlockRsc ret;
+
+    AGZ_D3D12_CHECK_HR(
+        device_->CreateCommittedResource(
+            get_temp_ptr(CD3DX12_HEAP_PROPERTIES(heapType_)),
+            D3D12_HEAP_FLAG_NONE,
+            get_temp_ptr(CD3DX12_RESOURCE_DESC::Buffer(size, flags_)),
+            initState_, nullptr,
+            IID_PPV_ARGS(ret.rsc.GetAddressOf())));
+
+    counter_.onAlloc(size);
+
+    if(heapType_ == D3D12_HEAP_TYPE_UPLOAD)
+    {
+        D3D12_RANGE readRange = { 0, 0 };
+        void *mappedData;
+        AGZ_D3D12_CHECK_HR(ret.rsc->Map(0, &readRange, &mappedData));
+        ret.mappedData = static_cast<char *>(mappedData);
+    }
+    else if(heapType_ == D3D12_HEAP_TYPE_READBACK)
+    {
+        void *mappedData;
+        AGZ_D3D12_CHECK_HR(ret.rsc->Map(0, nullptr, &mappedData));
+        ret.mappedData = static_cast<char *>(mappedData);
+    }
+
+    return ret;
+}
+
+AGZ_D3D12_END
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstring>
+
+#include <agz/d3d12/asset/chunkedLZ4.h>
+#include <agz/d3d12/asset/lz4.h>
+
+AGZ_D3D12_BEGIN
+
+namespace
+{
+    struct Header
+    {
+        uint32_t magic            = 0;
+        uint32_t version          = 0;
+        uint32_t chunkSize        = 0;
+        uint32_t chunkCount       = 0;
+        uint64_t decompressedSize = 0;
+    };
+
+    // offset is relative to the start of the data
+    struct ChunkDesc
+    {
+        uint64_t offset         = 0;
+        uint32_t compressedSize = 0;
+        uint32_t reserved       = 0;
+    };
+
+    constexpr uint32_t MAGIC   = 0x435a4741; // "AGZC"
+    constexpr uint32_t VERSION = 1;
+
+    // in 64-bit, so that a count exceeding uint32 is not truncated
+    uint64_t computeChunkCount(
+        uint64_t decompressedSize, uint32_t chunkSize) noexcept
+    {
+        const uint64_t fullChunks = decompressedSize / chunkSize;
+        return fullChunks + (decompressedSize % chunkSize != 0);
+    }
+
+} // namespace anonymous
+
+bool ChunkedLZ4View::Chunk::isStored() const noexcept
+{
+    return compressedSize == decompressedSize;
+}
+
+ChunkedLZ4View::ChunkedLZ4View() noexcept
+    : data_(nullptr), decompressedSize_(0), chunkSize_(0), chunkCount_(0)
+{
+
+}
+
+ChunkedLZ4View::ChunkedLZ4View(const void *data, size_t byteSize)
+    : ChunkedLZ4View()
+{
+    auto bytes = static_cast<const unsigned char *>(data);
+
+    Header header;
+    if(byteSize < sizeof(header))
+        throw D3D12LabException("chunked lz4: invalid header");
+    std::memcpy(&header, bytes, sizeof(header));
+
+    if(header.magic != MAGIC || header.version != VERSION ||
+       !header.chunkSize ||
+       uint64_t(header.chunkCount) != computeChunkCount(
+           header.decompressedSize, header.chunkSize))
+        throw D3D12LabException("chunked lz4: invalid header");
+
+    const uint64_t tableSize = uint64_t(header.chunkCount) * sizeof(ChunkDesc);
+    if(byteSize - sizeof(header) < tableSize)
+        throw D3D12LabException("chunked lz4: truncated chunk table");
+
+    data_             = bytes;
+    decompressedSize_ = header.decompressedSize;
+    chunkSize_        = header.chunkSize;
+    chunkCount_       = header.chunkCount;
+
+    // check chunk ranges once so that getChunk never reads out of data
+
+    for(uint32_t i = 0; i < chunkCount_; ++i)
+    {
+        ChunkDesc desc;
+        std::memcpy(
+            &desc, bytes + sizeof(header) + i * sizeof(ChunkDesc), sizeof(desc));
+
+        if(desc.offset > byteSize ||
+           desc.compressedSize > byteSize - desc.offset)
+            throw D3D12LabException("chunked lz4: chunk out of range");
+    }
+}
+
+uint64_t ChunkedLZ4View::getDecompressedSize() const noexcept
+{
+    return decompressedSize_;
+}
+
+uint32_t ChunkedLZ4View::getChunkSize() const noexcept
+{
+    return chunkSize_;
+}
+
+uint32_t ChunkedLZ4View::getChunkCount() const noexcept
+{
+    return chunkCount_;
+}
+
+ChunkedLZ4View::Chunk ChunkedLZ4View::getChunk(uint32_t index) const noexcept
+{
+    ChunkDesc desc;
+    std::memcpy(
+        &desc, data_ + sizeof(Header) + index * sizeof(ChunkDesc),
+        sizeof(desc));
+
+    Chunk ret;
+    ret.data               = data_ + desc.offset;
+    ret.compressedSize     = desc.compressedSize;
+    ret.decompressedOffset = uint64_t(index) * chunkSize_;
+    ret.decompressedSize   = static_cast<uint32_t>(
+        (std::min)(uint64_t(chunkSize_),
+                   decompressedSize_ - ret.decompressedOffset));
+    return ret;
+}
+
+void ChunkedLZ4View::decompressChunk(uint32_t index, void *dst) const
+{
+    const Chunk chunk = getChunk(index);
+
+    if(chunk.isStored())
+    {
+        std::memcpy(dst, chunk.data, chunk.decompressedSize);
+        return;
+    }
+
+    if(!lz4Decompress(
+        chunk.data, chunk.compressedSize, dst, chunk.decompressedSize))
+        throw D3D12LabException("chunked lz4: corrupted chunk");
+}
+
+void ChunkedLZ4View::decompress(void *dst) const
+{
+    auto bytes = static_cast<unsigned char *>(dst);
+    for(uint32_t i = 0; i < chunkCount_; ++i)
+        decompressChunk(i, bytes + uint64_t(i) * chunkSize_);
+}
+
+std::vector<unsigned char> compressChunkedLZ4(
+    const void *data,
+    size_t      byteSize,
+    uint32_t    chunkSize)
+{
+    if(!chunkSize)
+        throw D3D12LabException("chunked lz4: chunk size is zero");
+
+    const uint64_t chunkCount = computeChunkCount(byteSize, chunkSize);
+    if(chunkCount > UINT32_MAX)
+        throw D3D12LabException("chunked lz4: too many chunks");
+
+    auto src = static_cast<const unsigned char *>(data);
+
+    Header header;
+    header.magic            = MAGIC;
+    header.version          = VERSION;
+    header.chunkSize        = chunkSize;
+    header.chunkCount       = static_cast<uint32_t>(chunkCount);
+    header.decompressedSize = byteSize;
+
+    const size_t dataStart =
+        sizeof(header) + size_t(header.chunkCount) * sizeof(ChunkDesc);
+
+    std::vector<unsigned char> ret(dataStart);
+    std::vector<unsigned char> buffer(lz4CompressBound(chunkSize));
+
+    for(uint32_t i = 0; i < header.chunkCount; ++i)
+    {
+        const size_t offset = size_t(i) * chunkSize;
+        const size_t size   = (std::min)(size_t(chunkSize), byteSize - offset);
+
+        // store incompressible chunks as is
+
+        size_t compressedSize = lz4Compress(
+            src + offset, size, buffer.data(), buffer.size());
+
+        const unsigned char *chunkData = buffer.data();
+        if(!compressedSize || compressedSize >= size)
+        {
+            compressedSize = size;
+            chunkData      = src + offset;
+        }
+
+        ChunkDesc desc;
+        desc.offset         = ret.size();
+        desc.compressedSize = static_cast<uint32_t>(compressedSize);
+        std::memcpy(
+            ret.data() + sizeof(header) + i * sizeof(ChunkDesc),
+            &desc, sizeof(desc));
+
+        ret.insert(ret.end(), chunkData, chunkData + compressedSize);
+    }
+
+    std::memcpy(ret.data(), &header, sizeof(header));
+    return ret;
+}
+
+AGZ_D3D12_END
@@ -0,0 +1,93 @@
+#include <cstring>
+
+#include <agz/d3d12/framegraph/commandSignatureCache.h>
+
+AGZ_D3D12_FG_BEGIN
+
+bool CommandSignatureCache::Key::operator<(const Key &rhs) const noexcept
+{
+    if(byteStride != rhs.byteStride)
+        return byteStride < rhs.byteStride;
+
+    if(rootSignature != rhs.rootSignature)
+        return rootSignature.Get() < rhs.rootSignature.Get();
+
+    if(args.size() != rhs.args.size())
+        return args.size() < rhs.args.size();
+
+    return std::memcmp(
+        args.data(), rhs.args.data(),
+        sizeof(D3D12_INDIRECT_ARGUMENT_DESC) * args.size()) < 0;
+}
+
+CommandSignatureCache::CommandSignatureCache(ID3D12Device *device)
+    : device_(device)
+{
+    
+}
+
+ID3D12CommandSignature *CommandSignatureCache::getDispatchSignature(
+    UINT byteStride)
+{
+    D3D12_INDIRECT_ARGUMENT_DESC arg = {};
+    arg.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+    return getSignature(&arg, 1, byteStride);
+}
+
+ID3D12CommandSignature *CommandSignatureCache::getDrawSignature(
+    UINT byteStride)
+{
+    D3D12_INDIRECT_ARGUMENT_DESC arg = {};
+    arg.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+    return getSignature(&arg, 1, byteStride);
+}
+
+ID3D12CommandSignature *CommandSignatureCache::getDrawIndexedSignature(
+    UINT byteStride)
+{
+    D3D12_INDIRECT_ARGUMENT_DESC arg = {};
+    arg.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+    return getSignature(&arg, 1, byteStride);
+}
+
+ID3D12CommandSignature *CommandSignatureCache::getSignature(
+    const D3D12_INDIRECT_ARGUMENT_DESC *args,
+    UINT                                argCount,
+    UINT                                byteStride,
+    ID3D12RootSignature                *rootSignature)
+{
+    Key key;
+    key.args          = { args, args + argCount };
+    key.byteStride    = byteStride;
+    key.rootSignature = rootSignature;
+
+    std::lock_guard lk(mutex_);
+
+    if(auto it = signatures_.find(key); it != signatures_.end())
+        return it->second.Get();
+
+    D3D12_COMMAND_SIGNATURE_DESC desc;
+    desc.ByteStride       = byteStride;
+    desc.NumArgumentDescs = argCount;
+    desc.pArgumentDescs   = args;
+    desc.NodeMask         = 0;
+
+    ComPtr<ID3D12CommandSignature> signature;
+    AGZ_D3D12_CHECK_HR_MSG(
+        "failed to create command signature",
+        device_->CreateCommandSignature(
+            &desc, rootSignature,
+            IID_PPV_ARGS(signature.GetAddressOf())));
+
+    auto ret = signature.Get();
+    signatures_.insert({ std::move(key), std::move(signature) });
+    return ret;
+}
+
+void CommandSignatureCache::clear()
+{
+    std::lock_guard lk(mutex_);
+    signatures_.clear();
+}
+
+AGZ_D3D12_FG_END
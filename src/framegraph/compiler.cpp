@@ -2,13 +2,38 @@
 
 AGZ_D3D12_FG_BEGIN
 
+namespace
+{
+
+    UAVAccess getUAVAccess(
+        const FrameGraphCompiler::CompilerPassNode::RscInPass &rscUsage)
+    {
+        if(auto uav = rscUsage.viewDesc.as_if<_internalUAV>(); uav)
+            return uav->access;
+        return ReadWriteUAV;
+    }
+
+    // is a uav barrier required between two successive uav accesses
+    bool isUAVHazard(UAVAccess prev, UAVAccess next) noexcept
+    {
+        if(prev == ReadOnlyUAV && next == ReadOnlyUAV)
+            return false;
+
+        if(prev == NonOverlappingWriteUAV && next == NonOverlappingWriteUAV)
+            return false;
+
+        return true;
+    }
+
+} // namespace anonymous
+
 std::optional<D3D12_CLEAR_VALUE>
     FrameGraphCompiler::CompilerInternalResourceNode
         ::getClearValue() const noexcept
 {
     if(clearColor)
     {
-        D3D12_CLEAR_VALUE clearValue;
+        D3D12_CLEAR_VALUE clearValue = {};
         clearValue.Format = clearFormat;
         std::memcpy(clearValue.Color, &clearColorValue.r, sizeof(ClearColor));
         return clearValue;
@@ -16,7 +41,7 @@ std::optional<D3D12_CLEAR_VALUE>
 
     if(clearDepthStencil)
     {
-        D3D12_CLEAR_VALUE clearValue;
+        D3D12_CLEAR_VALUE clearValue = {};
         clearValue.Format               = clearFormat;
         clearValue.DepthStencil.Depth   = clearDepthStencilValue.depth;
         clearValue.DepthStencil.Stencil = clearDepthStencilValue.stencil;
@@ -113,6 +138,14 @@ FrameGraphData FrameGraphCompiler::compile(
     ret.rtvDescCount = usageInfo.rtvDescCount;
     ret.dsvDescCount = usageInfo.dsvDescCount;
 
+    // eliminate redundant clears
+
+    for(auto &pass : passes_)
+    {
+        for(auto &rscUsage : pass.rscs)
+            eliminateRedundantClear(pass, rscUsage, usageInfo.rscTempNodes);
+    }
+
     // infer rsc flags & clear values
 
     for(auto &pass : passes_)
@@ -121,6 +154,14 @@ FrameGraphData FrameGraphCompiler::compile(
             inferRscCreationFlagAndClearValue(rscUsage);
     }
 
+    // check fast clear values
+
+    for(auto &pass : passes_)
+    {
+        for(auto &rscUsage : pass.rscs)
+            checkFastClearValue(rscUsage, ret.warnings);
+    }
+
     // allocate d3d rsc
 
     for(auto &rsc : rscs_)
@@ -257,6 +298,89 @@ void FrameGraphCompiler::inferRscCreationFlagAndClearValue(
     }
 }
 
+void FrameGraphCompiler::eliminateRedundantClear(
+    const CompilerPassNode         &pass,
+    CompilerPassNode::RscInPass    &rscUsage,
+    const std::vector<TempRscNode> &rscTempNodes) const
+{
+    // depth stencil is always kept as it is read by the depth/stencil test
+
+    auto rtb = rscUsage.rtdsBinding
+        .as_if<FrameGraphPassNode::PassResource::RTB>();
+    if(!rtb || !rtb->clear)
+        return;
+
+    // render targets of a fullscreen pass are fully overwritten
+
+    if(pass.isFullscreen)
+    {
+        rtb->clear = false;
+        return;
+    }
+
+    // content of internal rscs is discarded after their last user
+
+    const auto &users = rscTempNodes[rscUsage.idx.idx].users;
+    const size_t nextUserIdx = static_cast<size_t>(rscUsage.idxInRscUsers) + 1;
+
+    if(nextUserIdx >= users.size())
+    {
+        if(rscs_[rscUsage.idx.idx].is<CompilerInternalResourceNode>())
+            rtb->clear = false;
+        return;
+    }
+
+    // next user renders to the whole target without reading it
+
+    const auto &nextUser = users[nextUserIdx];
+    if(nextUser.state == D3D12_RESOURCE_STATE_RENDER_TARGET &&
+       passes_[nextUser.pass.idx].isFullscreen)
+        rtb->clear = false;
+}
+
+void FrameGraphCompiler::checkFastClearValue(
+    const CompilerPassNode::RscInPass &rscUsage,
+    std::vector<std::string>          &warnings) const
+{
+    // clearing with a value different from the optimized clear value
+    // silently falls off the fast clear path
+
+    auto tn = rscs_[rscUsage.idx.idx].as_if<CompilerInternalResourceNode>();
+    if(!tn)
+        return;
+
+    bool isSlowClear = false;
+
+    if(auto rtb = rscUsage.rtdsBinding
+        .as_if<FrameGraphPassNode::PassResource::RTB>(); rtb && rtb->clear)
+    {
+        isSlowClear = !tn->clearColor ||
+                      rtb->clearColor.r != tn->clearColorValue.r ||
+                      rtb->clearColor.g != tn->clearColorValue.g ||
+                      rtb->clearColor.b != tn->clearColorValue.b ||
+                      rtb->clearColor.a != tn->clearColorValue.a;
+    }
+    else if(auto dsb = rscUsage.rtdsBinding
+        .as_if<FrameGraphPassNode::PassResource::DSB>();
+        dsb && (dsb->clearDepth || dsb->clearStencil))
+    {
+        const auto &value = dsb->clearDethpStencil;
+        const auto &opt   = tn->clearDepthStencilValue;
+
+        isSlowClear = !tn->clearDepthStencil ||
+                      (dsb->clearDepth   && value.depth   != opt.depth) ||
+                      (dsb->clearStencil && value.stencil != opt.stencil);
+    }
+
+    if(isSlowClear)
+    {
+        warnings.push_back(
+            "WARNING: framegraph: clear value of resource "
+            + std::to_string(rscUsage.idx.idx)
+            + " differs from its optimized clear value\n");
+    }
+}
+
 FrameGraphCompiler::RscUsageInfo FrameGraphCompiler::collectRscUsages()
 {
     RscUsageInfo info;
@@ -274,7 +398,8 @@ FrameGraphCompiler::RscUsageInfo FrameGraphCompiler::collectRscUsages()
             const int idxInRscUsers = static_cast<int>(tempRsc.users.size());
             rscUsage.idxInRscUsers = idxInRscUsers;
 
-            tempRsc.users.push_back({ passIdx, rscUsage.inState });
+            tempRsc.users.push_back(
+                { passIdx, rscUsage.inState, getUAVAccess(rscUsage) });
 
             match_variant(rscUsage.viewDesc,
                 [&](const _internalSRV &)  { ++info.gpuDescCount; },
@@ -337,14 +462,38 @@ FrameGraphCompiler::PassRscStates FrameGraphCompiler::getPassRscStates(
         return in.initialState;
     });
 
+    const bool isExternal = rscNode.is<CompilerExternalResourceNode>();
+    const UAVAccess uavAccess = getUAVAccess(rscUsage);
+
     if(rscUsage.idxInRscUsers > 0)
     {
-        ret.beforeState =
-            tempNode.users[rscUsage.idxInRscUsers - 1].second;
+        const auto &prevUser = tempNode.users[rscUsage.idxInRscUsers - 1];
+        ret.beforeState = prevUser.state;
+
+        ret.uavBarrierBefore =
+            prevUser.state == D3D12_RESOURCE_STATE_UNORDERED_ACCESS &&
+            isUAVHazard(prevUser.uavAccess, uavAccess);
     }
     else
+    {
         ret.beforeState = rscInitState;
 
+        // internal rsc: the previous access is made by the last user in the
+        // previous graph execution. external rsc may be accessed anywhere
+        // outside the graph
+
+        if(rscInitState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+        {
+            const auto &lastUser = tempNode.users.back();
+            ret.uavBarrierBefore =
+                isExternal ||
+                (lastUser.state == D3D12_RESOURCE_STATE_UNORDERED_ACCESS &&
+                 isUAVHazard(lastUser.uavAccess, uavAccess));
+        }
+        else
+            ret.uavBarrierBefore = false;
+    }
+
     ret.inState = rscUsage.inState;
 
     if(rscUsage.idxInRscUsers + 1 ==
@@ -359,9 +508,20 @@ FrameGraphCompiler::PassRscStates FrameGraphCompiler::getPassRscStates(
         {
             ret.afterState = rscInitState;
         });
+
+        // guard writes against uav accesses outside the graph
+
+        ret.uavBarrierAfter =
+            isExternal &&
+            ret.inState    == D3D12_RESOURCE_STATE_UNORDERED_ACCESS &&
+            ret.afterState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS &&
+            uavAccess != ReadOnlyUAV;
     }
     else
-        ret.afterState = rscUsage.inState;
+    {
+        ret.afterState      = rscUsage.inState;
+        ret.uavBarrierAfter = false;
+    }
 
     return ret;
 }
@@ -454,6 +614,9 @@ FrameGraphPassNode::PassResource FrameGraphCompiler::createFinalPassResource(
     passRsc.beforeState = states.beforeState;
     passRsc.inState     = states.inState;
     passRsc.afterState  = states.afterState;
+
+    passRsc.uavBarrierBefore = states.uavBarrierBefore;
+    passRsc.uavBarrierAfter  = states.uavBarrierAfter;
     
     // assign descriptor
     
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <agz/d3d12/framegraph/framegraph.h>
 
 AGZ_D3D12_FG_BEGIN
@@ -18,28 +20,51 @@ FrameGraph::FrameGraph(
       subGPUHeap_   (std::move(subGPUHeap)),
       rscAllocator_ (device, adaptor),
       graphReleaser_(device),
-      frameReleaser_(device),
-      executer_     (device, threadCount, frameCount)
+      executer_     (device, threadCount, frameCount),
+      cmdSigCache_  (device),
+      residencyMgr_ (nullptr)
 {
+    // all descriptors of the sub heaps are used by rings
+
+    auto initRing = [&](TransientDescriptorRing &ring, DescriptorSubHeap &heap)
+    {
+        if(heap.isAvailable() && heap.getCount())
+            ring.initialize(device, heap.allocRange(heap.getCount()));
+    };
 
+    initRing(rtvRing_, subRTVHeap_);
+    initRing(dsvRing_, subDSVHeap_);
+    initRing(gpuRing_, subGPUHeap_);
 }
 
 FrameGraph::~FrameGraph()
 {
     graphReleaser_.addReleasePoint(cmdQueue_);
-    frameReleaser_.addReleasePoint(cmdQueue_);
 }
 
 void FrameGraph::startFrame(int frameIndex)
 {
     executer_.startFrame(frameIndex);
     graphReleaser_.collect();
-    frameReleaser_.collect();
+    rscAllocator_.tick();
+
+    for(auto ring : { &rtvRing_, &dsvRing_, &gpuRing_ })
+    {
+        if(ring->isAvailable())
+            ring->startFrame();
+    }
+
+    if(defragmenter_)
+        defragmenter_->update();
 }
 
 void FrameGraph::endFrame()
 {
-    frameReleaser_.addReleasePoint(cmdQueue_);
+    for(auto ring : { &rtvRing_, &dsvRing_, &gpuRing_ })
+    {
+        if(ring->isAvailable())
+            ring->endFrame(cmdQueue_);
+    }
 }
 
 void FrameGraph::newGraph()
@@ -58,7 +83,31 @@ void FrameGraph::reset()
 void FrameGraph::compile()
 {
     graphReleaser_.addReleasePoint(cmdQueue_);
+
+    // return rscs of retired graphs to the pool before allocating new ones
+    graphReleaser_.collect();
+
     graphData_ = compiler_->compile(rscAllocator_, graphReleaser_);
+
+    for(auto &warning : graphData_.warnings)
+    {
+        if(reportedWarnings_.insert(warning).second)
+            OutputDebugStringA(warning.c_str());
+    }
+
+    // staging descriptors of previous graph are not referenced by gpu, so
+    // the heap can be recreated at any time
+
+    if(graphData_.gpuDescCount > stagingGPUDescs_.getCount())
+    {
+        const DescriptorCount size = (std::max)(
+            graphData_.gpuDescCount, 2 * stagingGPUDescs_.getCount());
+
+        stagingHeap_.destroy();
+        stagingHeap_.initialize(
+            device_, size, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, false);
+        stagingGPUDescs_ = stagingHeap_.allocRange(size);
+    }
 }
 
 void FrameGraph::setExternalRsc(
@@ -72,27 +121,90 @@ void FrameGraph::execute()
     DescriptorRange rtvRange;
     if(graphData_.rtvDescCount)
     {
-        rtvRange = subRTVHeap_.allocRange(graphData_.rtvDescCount);
-        frameReleaser_.add(subRTVHeap_, rtvRange);
+        rtvRange = rtvRing_.allocRange(graphData_.rtvDescCount);
     }
 
     DescriptorRange dsvRange;
     if(graphData_.dsvDescCount)
     {
-        dsvRange = subDSVHeap_.allocRange(graphData_.dsvDescCount);
-        frameReleaser_.add(subDSVHeap_, dsvRange);
+        dsvRange = dsvRing_.allocRange(graphData_.dsvDescCount);
     }
 
     DescriptorRange gpuRange;
     if(graphData_.gpuDescCount)
     {
-        gpuRange = subGPUHeap_.allocRange(graphData_.gpuDescCount);
-        frameReleaser_.add(subGPUHeap_, gpuRange);
+        gpuRange = gpuRing_.allocRange(graphData_.gpuDescCount);
+
+        for(auto &pass : graphData_.passNodes)
+        {
+            pass.prepareStagingDescriptors(
+                device_, graphData_.rscNodes, stagingGPUDescs_);
+        }
+
+        device_->CopyDescriptorsSimple(
+            graphData_.gpuDescCount,
+            gpuRange[0].getCPUHandle(),
+            stagingGPUDescs_[0].getCPUHandle(),
+            D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    }
+
+    if(residencyMgr_)
+    {
+        for(auto &node : graphData_.rscNodes)
+        {
+            if(auto rsc = node.getD3DResource())
+                rscAllocator_.useResidency(rsc);
+        }
+        residencyMgr_->makeResident();
     }
 
     executer_.execute(
         subGPUHeap_.getRawHeap(), graphData_,
         gpuRange, rtvRange, dsvRange, cmdQueue_);
+
+    if(residencyMgr_)
+        residencyMgr_->addUsePoint(cmdQueue_);
+}
+
+CommandSignatureCache &FrameGraph::getCommandSignatureCache() noexcept
+{
+    return cmdSigCache_;
+}
+
+void FrameGraph::setResidencyManager(ResidencyManager *residencyMgr)
+{
+    residencyMgr_ = residencyMgr;
+    rscAllocator_.setResidencyManager(residencyMgr);
+}
+
+AllocationStats FrameGraph::getAllocationStats() const
+{
+    return rscAllocator_.getStats();
+}
+
+void FrameGraph::enableDefragmentation(
+    ComPtr<ID3D12CommandQueue> copyQueue,
+    UINT64                     bytesPerFrame,
+    float                      maxHeapOccupancy)
+{
+    defragmenter_ = std::make_unique<ResourceDefragmenter>(
+        device_, rscAllocator_, cmdQueue_, std::move(copyQueue));
+    defragmenter_->setBudget(bytesPerFrame, maxHeapOccupancy);
+
+    defragmenter_->addRelocationCallback(
+        [this](ID3D12Resource *oldRsc, ID3D12Resource *newRsc)
+    {
+        for(auto &node : graphData_.rscNodes)
+        {
+            if(node.getD3DResource() == oldRsc)
+                node.relocateResource(newRsc);
+        }
+    });
+}
+
+ResourceDefragmenter *FrameGraph::getDefragmenter() noexcept
+{
+    return defragmenter_.get();
 }
 
 ResourceIndex FrameGraph::addInternalResource(
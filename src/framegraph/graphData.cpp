@@ -17,6 +17,13 @@ void FrameGraphResourceNode::setExternalResource(
     d3dRsc_ = d3dRsc;
 }
 
+void FrameGraphResourceNode::relocateResource(
+    ComPtr<ID3D12Resource> d3dRsc)
+{
+    assert(!isExternal_);
+    d3dRsc_ = d3dRsc;
+}
+
 ID3D12Resource *FrameGraphResourceNode::getD3DResource() const noexcept
 {
     return d3dRsc_.Get();
@@ -53,6 +60,38 @@ FrameGraphPassNode::FrameGraphPassNode(
     
 }
 
+void FrameGraphPassNode::prepareStagingDescriptors(
+    ID3D12Device                              *device,
+    const std::vector<FrameGraphResourceNode> &rscNodes,
+    DescriptorRange                            allStagingDescs) const
+{
+    for(auto &p : rscs_)
+    {
+        auto &r     = p.second;
+        auto d3dRsc = rscNodes[r.rscIdx.idx].getD3DResource();
+
+        // holding the cached rsc keeps new rscs from reusing its address
+
+        if(r.stagingRsc.Get() == d3dRsc)
+            continue;
+
+        match_variant(r.viewDesc,
+            [&](const _internalSRV &srv)
+        {
+            device->CreateShaderResourceView(
+                d3dRsc, &srv.desc, allStagingDescs[r.descIdx]);
+            r.stagingRsc = d3dRsc;
+        },
+            [&](const _internalUAV &uav)
+        {
+            device->CreateUnorderedAccessView(
+                d3dRsc, nullptr, &uav.desc, allStagingDescs[r.descIdx]);
+            r.stagingRsc = d3dRsc;
+        },
+            [&](const auto &) {});
+    }
+}
+
 template<bool IS_GRAPHICS>
 bool FrameGraphPassNode::executeImpl(
     ID3D12Device                        *device,
@@ -78,7 +117,7 @@ bool FrameGraphPassNode::executeImpl(
             inBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
                 d3dRsc, r.beforeState, r.inState));
         }
-        else if(r.beforeState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+        else if(r.uavBarrierBefore)
             inBarriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(d3dRsc));
 
         if(r.inState != r.afterState)
@@ -86,9 +125,8 @@ bool FrameGraphPassNode::executeImpl(
             outBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
                 d3dRsc, r.inState, r.afterState));
         }
-
-        // IMPROVE: out UAV barrier is omitted, which may cause problems
-        // if user uses it through uav after the fg execution
+        else if(r.uavBarrierAfter)
+            outBarriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(d3dRsc));
     }
 
     if(!inBarriers.empty())
@@ -110,18 +148,16 @@ bool FrameGraphPassNode::executeImpl(
         auto &r = p.second;
         auto d3dRsc = rscNodes[r.rscIdx.idx].getD3DResource();
         
+        // srvs & uavs are copied from staging descriptors
+
         match_variant(r.viewDesc,
-            [&](const _internalSRV &srv)
+            [&](const _internalSRV &)
         {
             r.descriptor = allGPUDescs[r.descIdx];
-            device->CreateShaderResourceView(
-                d3dRsc, &srv.desc, r.descriptor);
         },
-            [&](const _internalUAV &uav)
+            [&](const _internalUAV &)
         {
             r.descriptor = allGPUDescs[r.descIdx];
-            device->CreateUnorderedAccessView(
-                d3dRsc, nullptr, &uav.desc, r.descriptor);
         },
             [&](const _internalRTV &rtv)
         {
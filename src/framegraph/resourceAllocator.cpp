@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <tuple>
+
+#include <d3dx12.h>
+
+#include <agz/d3d12/framegraph/resourceAllocator.h>
+
+AGZ_D3D12_FG_BEGIN
+
+namespace
+{
+
+    auto toTuple(const D3D12_RESOURCE_DESC &d) noexcept
+    {
+        return std::make_tuple(
+            d.Dimension, d.Alignment, d.Width, d.Height,
+            d.DepthOrArraySize, d.MipLevels, d.Format,
+            d.SampleDesc.Count, d.SampleDesc.Quality,
+            d.Layout, d.Flags);
+    }
+
+} // namespace anonymous
+
+bool ResourceAllocator::ResourceDesc::operator<(
+    const ResourceDesc &rhs) const noexcept
+{
+    // compare field by field. padding bytes are not guaranteed to be zero
+
+    const auto lhsDesc = toTuple(desc);
+    const auto rhsDesc = toTuple(rhs.desc);
+    if(lhsDesc != rhsDesc)
+        return lhsDesc < rhsDesc;
+
+    if(clear != rhs.clear)
+        return clear < rhs.clear;
+
+    if(!clear)
+        return false;
+
+    return std::memcmp(&clearValue, &rhs.clearValue, sizeof(clearValue)) < 0;
+}
+
+bool ResourceAllocator::PoolKey::operator<(const PoolKey &rhs) const noexcept
+{
+    if(desc < rhs.desc)
+        return true;
+    if(rhs.desc < desc)
+        return false;
+    return state < rhs.state;
+}
+
+ResourceAllocator::ResourceAllocator(
+    ID3D12Device *device, IDXGIAdapter *adaptor)
+{
+    D3D12MA::ALLOCATOR_DESC allocatorDesc = {};
+    allocatorDesc.pDevice  = device;
+    allocatorDesc.pAdapter = adaptor;
+
+    D3D12MA::Allocator *allocator;
+    AGZ_D3D12_CHECK_HR(CreateAllocator(&allocatorDesc, &allocator));
+    d3d12MemAlloc_.reset(allocator);
+}
+
+ResourceAllocator::~ResourceAllocator()
+{
+    clearPool();
+
+    for(auto &rsc : allocatedRscs_)
+    {
+        onAllocationDestroyed(rsc.second.allocation, rsc.second.key.desc.desc);
+        rsc.second.allocation->Release();
+    }
+
+    for(auto &rsc : relocatedRscs_)
+    {
+        onAllocationDestroyed(rsc.second.allocation, rsc.second.key.desc.desc);
+        rsc.second.allocation->Release();
+    }
+}
+
+void ResourceAllocator::setPoolPolicy(
+    uint64_t maxUnusedTicks, UINT64 maxPoolBytes)
+{
+    maxUnusedTicks_ = maxUnusedTicks;
+    maxPoolBytes_   = maxPoolBytes;
+}
+
+ComPtr<ID3D12Resource> ResourceAllocator::allocResource(
+    const ResourceDesc    &desc,
+    D3D12_RESOURCE_STATES  expectedInitialState)
+{
+    const PoolKey key = { desc, expectedInitialState };
+
+    // reuse pooled rsc
+
+    if(auto it = pool_.find(key); it != pool_.end())
+    {
+        auto ret = std::move(it->second.rsc);
+        allocatedRscs_[ret] = { it->second.allocation, key };
+
+        pooledBytes_ -= it->second.allocation->GetSize();
+        onAllocationInUse(it->second.allocation, true);
+        pool_.erase(it);
+
+        return ret;
+    }
+
+    // create new rsc
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12MA::Allocation *allocation;
+    ComPtr<ID3D12Resource> ret;
+    AGZ_D3D12_CHECK_HR(
+        d3d12MemAlloc_->CreateResource(
+            &allocDesc, &desc.desc,
+            expectedInitialState,
+            desc.clear ? &desc.clearValue : nullptr,
+            &allocation, IID_PPV_ARGS(ret.GetAddressOf())));
+
+    allocatedRscs_[ret] = { allocation, key };
+
+    categoryCounters_[static_cast<int>(getAllocationCategory(
+        desc.desc, D3D12_HEAP_TYPE_DEFAULT))].onAlloc(allocation->GetSize());
+
+    onAllocationCreated(allocation);
+    onAllocationInUse(allocation, true);
+
+    return ret;
+}
+
+void ResourceAllocator::freeResource(ComPtr<ID3D12Resource> rsc)
+{
+    // follow relocations
+
+    for(auto r = relocations_.find(rsc.Get()); r != relocations_.end();
+        r = relocations_.find(rsc.Get()))
+    {
+        rsc = std::move(r->second.newRsc);
+        relocations_.erase(r);
+    }
+
+    const auto it = allocatedRscs_.find(rsc);
+    assert(it != allocatedRscs_.end());
+
+    PooledRsc pooled;
+    pooled.rsc        = std::move(rsc);
+    pooled.allocation = it->second.allocation;
+    pooled.freeTick   = curTick_;
+
+    pooledBytes_ += pooled.allocation->GetSize();
+    onAllocationInUse(pooled.allocation, false);
+    pool_.insert({ it->second.key, std::move(pooled) });
+
+    allocatedRscs_.erase(it);
+}
+
+void ResourceAllocator::tick()
+{
+    ++curTick_;
+
+    // evict rscs unused for too long
+
+    for(auto it = pool_.begin(); it != pool_.end();)
+    {
+        auto next = std::next(it);
+        if(curTick_ - it->second.freeTick > maxUnusedTicks_)
+            evict(it);
+        it = next;
+    }
+
+    // evict least recently freed rscs until under budget
+
+    while(pooledBytes_ > maxPoolBytes_)
+    {
+        assert(!pool_.empty());
+
+        auto oldest = pool_.begin();
+        for(auto it = std::next(oldest); it != pool_.end(); ++it)
+        {
+            if(it->second.freeTick < oldest->second.freeTick)
+                oldest = it;
+        }
+
+        evict(oldest);
+    }
+}
+
+void ResourceAllocator::clearPool()
+{
+    while(!pool_.empty())
+        evict(pool_.begin());
+}
+
+void ResourceAllocator::setResidencyManager(ResidencyManager *residencyMgr)
+{
+    assert(allocatedRscs_.empty() && pool_.empty());
+    residencyMgr_ = residencyMgr;
+}
+
+void ResourceAllocator::useResidency(ID3D12Resource *rsc)
+{
+    if(!residencyMgr_)
+        return;
+
+    // allocatedRscs_ is keyed by ComPtr. wrapping rsc only adds a reference
+
+    const auto it = allocatedRscs_.find(ComPtr<ID3D12Resource>(rsc));
+    residencyMgr_->use(
+        it != allocatedRscs_.end() ? getPageable(it->second.allocation) : rsc);
+}
+
+AllocationStats ResourceAllocator::getStats() const
+{
+    AllocationStats ret;
+    ret.frame       = curTick_;
+    ret.pooledBytes = pooledBytes_;
+
+    auto toHeapStats = [](const D3D12MA::StatInfo &info)
+    {
+        HeapStats heap;
+        heap.blockCount       = info.BlockCount;
+        heap.allocationCount  = info.AllocationCount;
+        heap.unusedRangeCount = info.UnusedRangeCount;
+        heap.usedBytes        = info.UsedBytes;
+        heap.unusedBytes      = info.UnusedBytes;
+        heap.maxUnusedRange   = info.UnusedRangeCount ?
+                                info.UnusedRangeSizeMax : 0;
+        return heap;
+    };
+
+    D3D12MA::Stats stats;
+    d3d12MemAlloc_->CalculateStats(&stats);
+
+    ret.total = toHeapStats(stats.Total);
+    for(int i = 0; i < 3; ++i)
+        ret.heaps[i] = toHeapStats(stats.HeapType[i]);
+
+    for(int i = 0; i < ALLOCATION_CATEGORY_COUNT; ++i)
+        ret.categories[i] = categoryCounters_[i];
+
+    return ret;
+}
+
+std::vector<ResourceAllocator::RelocationCandidate>
+    ResourceAllocator::getRelocationCandidates(float maxOccupancy) const
+{
+    const auto heapUsedBytes = getHeapUsedBytes();
+
+    std::vector<RelocationCandidate> ret;
+    for(auto &r : allocatedRscs_)
+    {
+        if(!r.second.allocation->GetHeap())
+            continue;
+
+        const float occupancy = getOccupancy(heapUsedBytes, r.second.allocation);
+        if(occupancy < maxOccupancy)
+        {
+            ret.push_back(
+                {
+                    r.first, r.second.key.state,
+                    r.second.allocation->GetSize(), occupancy
+                });
+        }
+    }
+
+    std::stable_sort(ret.begin(), ret.end(),
+        [](const RelocationCandidate &a, const RelocationCandidate &b)
+    {
+        return a.heapOccupancy < b.heapOccupancy;
+    });
+
+    return ret;
+}
+
+UINT64 ResourceAllocator::evictSparsePooledRscs(float maxOccupancy)
+{
+    const auto heapUsedBytes = getHeapUsedBytes();
+
+    UINT64 ret = 0;
+    for(auto it = pool_.begin(); it != pool_.end();)
+    {
+        auto next = std::next(it);
+
+        auto allocation = it->second.allocation;
+        if(allocation->GetHeap() &&
+           getOccupancy(heapUsedBytes, allocation) < maxOccupancy)
+        {
+            ret += allocation->GetSize();
+            evict(it);
+        }
+
+        it = next;
+    }
+
+    return ret;
+}
+
+ComPtr<ID3D12Resource> ResourceAllocator::allocRelocationTarget(
+    ID3D12Resource *rsc)
+{
+    const auto it = allocatedRscs_.find(ComPtr<ID3D12Resource>(rsc));
+    assert(it != allocatedRscs_.end());
+
+    const auto key = it->second.key;
+
+    D3D12MA::ALLOCATION_DESC allocDesc = {};
+    allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+
+    D3D12MA::Allocation *allocation;
+    ComPtr<ID3D12Resource> ret;
+    AGZ_D3D12_CHECK_HR(
+        d3d12MemAlloc_->CreateResource(
+            &allocDesc, &key.desc.desc, key.state,
+            key.desc.clear ? &key.desc.clearValue : nullptr,
+            &allocation, IID_PPV_ARGS(ret.GetAddressOf())));
+
+    // moving within the same heap, into a new heap or into a sparser heap
+    // recovers nothing
+
+    const auto heapUsedBytes = getHeapUsedBytes();
+    auto oldHeap = it->second.allocation->GetHeap();
+    auto newHeap = allocation->GetHeap();
+
+    if(!newHeap || newHeap == oldHeap ||
+       heapUsedBytes.find(newHeap) == heapUsedBytes.end() ||
+       getOccupancy(heapUsedBytes, allocation) <
+       getOccupancy(heapUsedBytes, it->second.allocation))
+    {
+        ret.Reset();
+        allocation->Release();
+        return nullptr;
+    }
+
+    allocatedRscs_[ret] = { allocation, key };
+
+    categoryCounters_[static_cast<int>(getAllocationCategory(
+        key.desc.desc, D3D12_HEAP_TYPE_DEFAULT))].onAlloc(allocation->GetSize());
+
+    onAllocationCreated(allocation);
+    onAllocationInUse(allocation, true);
+
+    return ret;
+}
+
+void ResourceAllocator::relocateResource(
+    ID3D12Resource *oldRsc, ComPtr<ID3D12Resource> newRsc)
+{
+    const auto it = allocatedRscs_.find(ComPtr<ID3D12Resource>(oldRsc));
+    assert(it != allocatedRscs_.end());
+
+    relocations_[oldRsc] = { it->first, std::move(newRsc) };
+    relocatedRscs_[oldRsc] = it->second;
+
+    allocatedRscs_.erase(it);
+}
+
+void ResourceAllocator::releaseRelocatedResource(ID3D12Resource *oldRsc)
+{
+    const auto it = relocatedRscs_.find(oldRsc);
+    assert(it != relocatedRscs_.end());
+
+    onAllocationDestroyed(it->second.allocation, it->second.key.desc.desc);
+    it->second.allocation->Release();
+
+    relocatedRscs_.erase(it);
+}
+
+UINT64 ResourceAllocator::getTotalBlockBytes() const
+{
+    D3D12MA::Stats stats;
+    d3d12MemAlloc_->CalculateStats(&stats);
+
+    const auto &info = stats.HeapType[0];
+    return info.UsedBytes + info.UnusedBytes;
+}
+
+void ResourceAllocator::evict(Pool::iterator it)
+{
+    pooledBytes_ -= it->second.allocation->GetSize();
+    onAllocationDestroyed(it->second.allocation, it->first.desc.desc);
+
+    it->second.rsc.Reset();
+    it->second.allocation->Release();
+
+    pool_.erase(it);
+}
+
+std::map<ID3D12Heap *, UINT64> ResourceAllocator::getHeapUsedBytes() const
+{
+    std::map<ID3D12Heap *, UINT64> ret;
+
+    auto add = [&](D3D12MA::Allocation *allocation)
+    {
+        if(auto heap = allocation->GetHeap())
+            ret[heap] += allocation->GetSize();
+    };
+
+    for(auto &r : allocatedRscs_)
+        add(r.second.allocation);
+    for(auto &r : relocatedRscs_)
+        add(r.second.allocation);
+    for(auto &r : pool_)
+        add(r.second.allocation);
+
+    return ret;
+}
+
+float ResourceAllocator::getOccupancy(
+    const std::map<ID3D12Heap *, UINT64> &heapUsedBytes,
+    D3D12MA::Allocation                  *allocation)
+{
+    auto heap = allocation->GetHeap();
+    const UINT64 heapSize = heap->GetDesc().SizeInBytes;
+    return static_cast<float>(
+        static_cast<double>(heapUsedBytes.at(heap)) / heapSize);
+}
+
+ID3D12Pageable *ResourceAllocator::getPageable(D3D12MA::Allocation *allocation)
+{
+    if(auto heap = allocation->GetHeap())
+        return heap;
+    return allocation->GetResource();
+}
+
+void ResourceAllocator::onAllocationCreated(D3D12MA::Allocation *allocation)
+{
+    if(!residencyMgr_)
+        return;
+
+    auto pageable = getPageable(allocation);
+    if(!pageables_[pageable].allocationCount++)
+    {
+        if(auto heap = allocation->GetHeap())
+            residencyMgr_->track(heap, heap->GetDesc().SizeInBytes, false);
+        else
+            residencyMgr_->track(allocation->GetResource(), false);
+    }
+}
+
+void ResourceAllocator::onAllocationInUse(
+    D3D12MA::Allocation *allocation, bool inUse)
+{
+    if(!residencyMgr_)
+        return;
+
+    auto pageable = getPageable(allocation);
+    auto &usage = pageables_[pageable];
+
+    if(inUse)
+    {
+        if(!usage.inUseCount++)
+            residencyMgr_->pin(pageable);
+        residencyMgr_->use(pageable);
+    }
+    else if(!--usage.inUseCount)
+        residencyMgr_->unpin(pageable);
+}
+
+void ResourceAllocator::onAllocationDestroyed(
+    D3D12MA::Allocation *allocation, const D3D12_RESOURCE_DESC &desc)
+{
+    categoryCounters_[static_cast<int>(getAllocationCategory(
+        desc, D3D12_HEAP_TYPE_DEFAULT))].onFree(allocation->GetSize());
+
+    if(!residencyMgr_)
+        return;
+
+    auto pageable = getPageable(allocation);
+    const auto it = pageables_.find(pageable);
+    assert(it != pageables_.end());
+
+    if(!--it->second.allocationCount)
+    {
+        residencyMgr_->untrack(pageable);
+        pageables_.erase(it);
+    }
+}
+
+AGZ_D3D12_FG_END
@@ -0,0 +1,208 @@
+#include <d3dx12.h>
+
+#include <agz/d3d12/framegraph/resourceDefragmenter.h>
+
+AGZ_D3D12_FG_BEGIN
+
+namespace
+{
+
+    bool isCopyQueueMovable(ID3D12Resource *rsc)
+    {
+        const auto desc = rsc->GetDesc();
+        return !(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) &&
+               desc.SampleDesc.Count <= 1;
+    }
+
+} // namespace anonymous
+
+ResourceDefragmenter::ResourceDefragmenter(
+    ID3D12Device              *device,
+    ResourceAllocator         &rscAlloc,
+    ID3D12CommandQueue        *graphicsQueue,
+    ComPtr<ID3D12CommandQueue> copyQueue)
+    : rscAlloc_(rscAlloc),
+      graphicsQueue_(graphicsQueue),
+      copyQueue_(std::move(copyQueue)),
+      nextFenceValue_(1),
+      curCmdListIdx_(0),
+      bytesPerFrame_(UINT64(8) << 20),
+      maxOccupancy_(0.5f),
+      movedBytes_(0),
+      recoveredBytes_(0)
+{
+    AGZ_D3D12_CHECK_HR(
+        device->CreateFence(
+            0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(fence_.GetAddressOf())));
+
+    cmdLists_.resize(3);
+    for(auto &c : cmdLists_)
+    {
+        c.pre .initialize(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+        c.copy.initialize(device, D3D12_COMMAND_LIST_TYPE_COPY);
+        c.post.initialize(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+    }
+}
+
+ResourceDefragmenter::~ResourceDefragmenter()
+{
+    fence_->SetEventOnCompletion(nextFenceValue_ - 1, nullptr);
+    releaseFinishedMoves();
+}
+
+void ResourceDefragmenter::setBudget(UINT64 bytesPerFrame, float maxOccupancy)
+{
+    bytesPerFrame_ = bytesPerFrame;
+    maxOccupancy_  = maxOccupancy;
+}
+
+void ResourceDefragmenter::addRelocationCallback(RelocationCallback callback)
+{
+    callbacks_.push_back(std::move(callback));
+}
+
+void ResourceDefragmenter::update()
+{
+    releaseFinishedMoves();
+
+    const auto moves = selectMoves();
+    if(!moves.empty())
+        submitMoves(moves);
+}
+
+UINT64 ResourceDefragmenter::getMovedBytes() const noexcept
+{
+    return movedBytes_;
+}
+
+UINT64 ResourceDefragmenter::getRecoveredBytes() const noexcept
+{
+    return recoveredBytes_;
+}
+
+void ResourceDefragmenter::releaseFinishedMoves()
+{
+    const UINT64 blockBytesBefore = rscAlloc_.getTotalBlockBytes();
+
+    const UINT64 completedValue = fence_->GetCompletedValue();
+    while(!pendingReleases_.empty() &&
+          pendingReleases_.front().fenceValue <= completedValue)
+    {
+        rscAlloc_.releaseRelocatedResource(pendingReleases_.front().oldRsc);
+        pendingReleases_.pop_front();
+    }
+
+    rscAlloc_.evictSparsePooledRscs(maxOccupancy_);
+
+    const UINT64 blockBytesAfter = rscAlloc_.getTotalBlockBytes();
+    if(blockBytesAfter < blockBytesBefore)
+        recoveredBytes_ += blockBytesBefore - blockBytesAfter;
+}
+
+std::vector<ResourceDefragmenter::Move> ResourceDefragmenter::selectMoves()
+{
+    std::vector<Move> ret;
+    UINT64 bytes = 0;
+
+    for(auto &c : rscAlloc_.getRelocationCandidates(maxOccupancy_))
+    {
+        if(bytes + c.size > bytesPerFrame_)
+            continue;
+
+        if(!isCopyQueueMovable(c.rsc.Get()))
+            continue;
+
+        auto newRsc = rscAlloc_.allocRelocationTarget(c.rsc.Get());
+        if(!newRsc)
+            continue;
+
+        bytes += c.size;
+        ret.push_back({ c.rsc, std::move(newRsc), c.state });
+    }
+
+    movedBytes_ += bytes;
+    return ret;
+}
+
+void ResourceDefragmenter::submitMoves(const std::vector<Move> &moves)
+{
+    auto &c = cmdLists_[curCmdListIdx_];
+    curCmdListIdx_ = (curCmdListIdx_ + 1) % cmdLists_.size();
+
+    fence_->SetEventOnCompletion(c.expectedFenceValue, nullptr);
+
+    c.pre .resetCommandList();
+    c.copy.resetCommandList();
+    c.post.resetCommandList();
+
+    // copy queue can only access rscs in COMMON state, from which
+    // copy states are implicitly promoted
+
+    std::vector<D3D12_RESOURCE_BARRIER> preBarriers, postBarriers;
+    for(auto &m : moves)
+    {
+        if(m.state == D3D12_RESOURCE_STATE_COMMON)
+            continue;
+
+        for(auto rsc : { m.oldRsc.Get(), m.newRsc.Get() })
+        {
+            preBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+                rsc, m.state, D3D12_RESOURCE_STATE_COMMON));
+            postBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+                rsc, D3D12_RESOURCE_STATE_COMMON, m.state));
+        }
+    }
+
+    for(auto &m : moves)
+        c.copy->CopyResource(m.newRsc.Get(), m.oldRsc.Get());
+
+    if(!preBarriers.empty())
+    {
+        c.pre ->ResourceBarrier(
+            static_cast<UINT>(preBarriers.size()), preBarriers.data());
+        c.post->ResourceBarrier(
+            static_cast<UINT>(postBarriers.size()), postBarriers.data());
+    }
+
+    c.pre ->Close();
+    c.copy->Close();
+    c.post->Close();
+
+    // graphics (pre) -> copy -> graphics (post). the copy waits for all
+    // previously submitted graphics work accessing old rscs
+
+    ID3D12CommandList *preList [] = { c.pre  };
+    ID3D12CommandList *copyList[] = { c.copy };
+    ID3D12CommandList *postList[] = { c.post };
+
+    if(!preBarriers.empty())
+        graphicsQueue_->ExecuteCommandLists(1, preList);
+    graphicsQueue_->Signal(fence_.Get(), nextFenceValue_);
+    copyQueue_->Wait(fence_.Get(), nextFenceValue_++);
+
+    copyQueue_->ExecuteCommandLists(1, copyList);
+    copyQueue_->Signal(fence_.Get(), nextFenceValue_);
+    graphicsQueue_->Wait(fence_.Get(), nextFenceValue_++);
+
+    if(!postBarriers.empty())
+        graphicsQueue_->ExecuteCommandLists(1, postList);
+    graphicsQueue_->Signal(fence_.Get(), nextFenceValue_);
+
+    c.expectedFenceValue = nextFenceValue_;
+
+    // following cmd lists are ordered after the copy, so bindings can be
+    // patched now
+
+    for(auto &m : moves)
+    {
+        rscAlloc_.relocateResource(m.oldRsc.Get(), m.newRsc);
+        for(auto &callback : callbacks_)
+            callback(m.oldRsc.Get(), m.newRsc.Get());
+
+        pendingReleases_.push_back({ nextFenceValue_, m.oldRsc.Get() });
+    }
+
+    ++nextFenceValue_;
+}
+
+AGZ_D3D12_FG_END
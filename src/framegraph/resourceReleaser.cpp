@@ -12,34 +12,23 @@ ResourceReleaser::ResourceReleaser(ID3D12Device *device)
 
 ResourceReleaser::~ResourceReleaser()
 {
+    if(records_.empty())
+        return;
+
+    fence_->SetEventOnCompletion(records_.back().expectedFenceValue, nullptr);
     for(auto &r : records_)
-    {
-        fence_->SetEventOnCompletion(r.expectedFenceValue, nullptr);
-        match_variant(r.releaser,
-            [&](ObjRecord             &   ) {                },
-            [&](RscAllocRecord        &rar) { rar.release(); },
-            [&](DescriptorRangeRecord &drr) { drr.release(); },
-            [&](DescriptorHeapRecord  &dhr) { dhr.release(); });
-    }
+        release(r);
 }
 
 void ResourceReleaser::collect()
 {
-    std::vector<Record> newRecords;
-    for(auto &r : records_)
+    const UINT64 completedValue = fence_->GetCompletedValue();
+    while(!records_.empty() &&
+          records_.front().expectedFenceValue <= completedValue)
     {
-        if(fence_->GetCompletedValue() >= r.expectedFenceValue)
-        {
-            match_variant(r.releaser,
-                [&](ObjRecord             &   ) {                },
-                [&](RscAllocRecord        &rar) { rar.release(); },
-                [&](DescriptorRangeRecord &drr) { drr.release(); },
-                [&](DescriptorHeapRecord  &dhr) { dhr.release(); });
-        }
-        else
-            newRecords.push_back(std::move(r));
+        release(records_.front());
+        records_.pop_front();
     }
-    records_.swap(newRecords);
 }
 
 void ResourceReleaser::addReleasePoint(ID3D12CommandQueue *cmdQueue)
@@ -82,4 +71,13 @@ void ResourceReleaser::add(std::unique_ptr<DescriptorHeap> heap)
         });
 }
 
+void ResourceReleaser::release(Record &record)
+{
+    match_variant(record.releaser,
+        [&](ObjRecord             &   ) {                },
+        [&](RscAllocRecord        &rar) { rar.release(); },
+        [&](DescriptorRangeRecord &drr) { drr.release(); },
+        [&](DescriptorHeapRecord  &dhr) { dhr.release(); });
+}
+
 AGZ_D3D12_FG_END
@@ -0,0 +1,218 @@
+#include <cstdint>
+#include <cstring>
+
+#include <agz/d3d12/asset/lz4.h>
+
+AGZ_D3D12_BEGIN
+
+namespace
+{
+    constexpr size_t MIN_MATCH     = 4;
+    constexpr size_t LAST_LITERALS = 5;  // last bytes are always literals
+    constexpr size_t MF_LIMIT      = 12; // last match starts before this
+    constexpr size_t MAX_OFFSET    = 65535;
+
+    constexpr int HASH_LOG = 14;
+
+    uint32_t read32(const uint8_t *p) noexcept
+    {
+        uint32_t ret;
+        std::memcpy(&ret, p, sizeof(ret));
+        return ret;
+    }
+
+    uint32_t hash32(uint32_t seq) noexcept
+    {
+        return (seq * 2654435761u) >> (32 - HASH_LOG);
+    }
+
+    // write 'len - 15' as a sequence of 255s ended by a smaller byte
+    bool writeLength(uint8_t *&op, const uint8_t *oend, size_t len) noexcept
+    {
+        for(; len >= 255; len -= 255)
+        {
+            if(op == oend)
+                return false;
+            *op++ = 255;
+        }
+
+        if(op == oend)
+            return false;
+        *op++ = static_cast<uint8_t>(len);
+        return true;
+    }
+
+    bool readLength(
+        const uint8_t *&ip, const uint8_t *iend, size_t &len) noexcept
+    {
+        for(;;)
+        {
+            if(ip == iend)
+                return false;
+            const uint8_t b = *ip++;
+            len += b;
+            if(b != 255)
+                return true;
+        }
+    }
+
+    // match is empty for the last sequence
+    bool writeSequence(
+        uint8_t      *&op,
+        const uint8_t *oend,
+        const uint8_t *literals,
+        size_t         literalLength,
+        size_t         offset,
+        size_t         matchLength) noexcept
+    {
+        if(op == oend)
+            return false;
+
+        uint8_t *token = op++;
+        *token = static_cast<uint8_t>(
+            (literalLength < 15 ? literalLength : 15) << 4);
+
+        if(literalLength >= 15 && !writeLength(op, oend, literalLength - 15))
+            return false;
+
+        if(size_t(oend - op) < literalLength)
+            return false;
+        if(literalLength)
+            std::memcpy(op, literals, literalLength);
+        op += literalLength;
+
+        if(!matchLength)
+            return true;
+
+        if(oend - op < 2)
+            return false;
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+
+        const size_t ml = matchLength - MIN_MATCH;
+        *token |= static_cast<uint8_t>(ml < 15 ? ml : 15);
+
+        return ml < 15 || writeLength(op, oend, ml - 15);
+    }
+
+} // namespace anonymous
+
+size_t lz4Compress(
+    const void *src, size_t srcSize, void *dst, size_t dstCapacity) noexcept
+{
+    auto in  = static_cast<const uint8_t *>(src);
+    auto op  = static_cast<uint8_t *>(dst);
+    auto oend = op + dstCapacity;
+
+    size_t anchor = 0;
+
+    if(srcSize > MF_LIMIT)
+    {
+        // positions are stored plus one. 0 means empty
+        uint32_t table[1 << HASH_LOG] = {};
+
+        const size_t matchLimit = srcSize - LAST_LITERALS;
+        const size_t mfLimit    = srcSize - MF_LIMIT;
+
+        size_t ip = 0;
+        while(ip < mfLimit)
+        {
+            const uint32_t seq = read32(in + ip);
+            const uint32_t h   = hash32(seq);
+            const size_t   ref = table[h];
+            table[h] = static_cast<uint32_t>(ip + 1);
+
+            if(!ref || ip - (ref - 1) > MAX_OFFSET || read32(in + ref - 1) != seq)
+            {
+                ++ip;
+                continue;
+            }
+
+            const size_t matchPos = ref - 1;
+            size_t len = MIN_MATCH;
+            while(ip + len < matchLimit && in[matchPos + len] == in[ip + len])
+                ++len;
+
+            if(!writeSequence(
+                op, oend, in + anchor, ip - anchor, ip - matchPos, len))
+                return 0;
+
+            ip    += len;
+            anchor = ip;
+        }
+    }
+
+    if(!writeSequence(op, oend, in + anchor, srcSize - anchor, 0, 0))
+        return 0;
+
+    return static_cast<size_t>(op - static_cast<uint8_t *>(dst));
+}
+
+bool lz4Decompress(
+    const void *src, size_t srcSize, void *dst, size_t dstSize) noexcept
+{
+    auto ip   = static_cast<const uint8_t *>(src);
+    auto iend = ip + srcSize;
+    auto ostart = static_cast<uint8_t *>(dst);
+    auto op     = ostart;
+    auto oend   = op + dstSize;
+
+    for(;;)
+    {
+        if(ip == iend)
+            return false;
+        const uint8_t token = *ip++;
+
+        // literals
+
+        size_t literalLength = token >> 4;
+        if(literalLength == 15 && !readLength(ip, iend, literalLength))
+            return false;
+
+        if(size_t(iend - ip) < literalLength ||
+           size_t(oend - op) < literalLength)
+            return false;
+
+        if(literalLength)
+            std::memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        // the last sequence contains only literals
+
+        if(ip == iend)
+            return op == oend;
+
+        // match
+
+        if(iend - ip < 2)
+            return false;
+        const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+        ip += 2;
+
+        if(!offset || offset > size_t(op - ostart))
+            return false;
+
+        size_t matchLength = token & 15;
+        if(matchLength == 15 && !readLength(ip, iend, matchLength))
+            return false;
+        matchLength += MIN_MATCH;
+
+        if(size_t(oend - op) < matchLength)
+            return false;
+
+        // overlapping match repeats the last 'offset' bytes
+
+        const uint8_t *match = op - offset;
+        if(offset >= matchLength)
+            std::memcpy(op, match, matchLength);
+        else
+        {
+            for(size_t i = 0; i < matchLength; ++i)
+                op[i] = match[i];
+        }
+        op += matchLength;
+    }
+}
+
+AGZ_D3D12_END
@@ -0,0 +1,228 @@
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+#include <agz/d3d12/asset/mappedFile.h>
+
+AGZ_D3D12_BEGIN
+
+namespace
+{
+#ifndef _WIN32
+
+    // expand [offset, offset + size) to page boundaries as madvise requires
+    std::pair<const unsigned char *, size_t> alignToPages(
+        const unsigned char *data, size_t offset, size_t size)
+    {
+        const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t beg = offset / pageSize * pageSize;
+        return { data + beg, size + (offset - beg) };
+    }
+
+#endif
+
+} // namespace anonymous
+
+MappedFile::MappedFile() noexcept
+    : data_(nullptr), size_(0)
+#ifdef _WIN32
+    , file_(INVALID_HANDLE_VALUE), mapping_(nullptr)
+#endif
+{
+
+}
+
+MappedFile::MappedFile(const std::string &filename)
+    : MappedFile()
+{
+    open(filename);
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : MappedFile()
+{
+    swap(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+void MappedFile::swap(MappedFile &other) noexcept
+{
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+#ifdef _WIN32
+    std::swap(file_,    other.file_);
+    std::swap(mapping_, other.mapping_);
+#endif
+}
+
+#ifdef _WIN32
+
+void MappedFile::open(const std::string &filename)
+{
+    close();
+
+    misc::scope_guard_t closeGuard([&] { close(); });
+
+    file_ = CreateFileA(
+        filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file_ == INVALID_HANDLE_VALUE)
+        throw D3D12LabException("mapped file: failed to open " + filename);
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file_, &size))
+        throw D3D12LabException("mapped file: failed to stat " + filename);
+    size_ = static_cast<size_t>(size.QuadPart);
+
+    // empty file cannot be mapped
+
+    if(size_)
+    {
+        mapping_ = CreateFileMappingA(
+            file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(!mapping_)
+            throw D3D12LabException("mapped file: failed to map " + filename);
+
+        data_ = static_cast<const unsigned char *>(
+            MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if(!data_)
+            throw D3D12LabException("mapped file: failed to map " + filename);
+    }
+
+    closeGuard.dismiss();
+}
+
+bool MappedFile::isOpen() const noexcept
+{
+    return file_ != INVALID_HANDLE_VALUE;
+}
+
+void MappedFile::close()
+{
+    if(data_)
+        UnmapViewOfFile(data_);
+    if(mapping_)
+        CloseHandle(mapping_);
+    if(file_ != INVALID_HANDLE_VALUE)
+        CloseHandle(file_);
+
+    data_    = nullptr;
+    size_    = 0;
+    file_    = INVALID_HANDLE_VALUE;
+    mapping_ = nullptr;
+}
+
+void MappedFile::adviseSequential()
+{
+    // FILE_FLAG_SEQUENTIAL_SCAN is given when opening
+}
+
+void MappedFile::prefetch(size_t offset, size_t size)
+{
+    if(offset >= size_)
+        return;
+
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<unsigned char *>(data_ + offset);
+    range.NumberOfBytes  = (std::min)(size, size_ - offset);
+
+    // only a hint. failure is ignored
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+void MappedFile::open(const std::string &filename)
+{
+    close();
+
+    const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+        throw D3D12LabException("mapped file: failed to open " + filename);
+
+    // the mapping keeps the file referenced after fd is closed
+
+    misc::scope_guard_t fdGuard([&] { ::close(fd); });
+
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+        throw D3D12LabException("mapped file: failed to stat " + filename);
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    if(!size)
+    {
+        // empty file cannot be mapped. use a non-null dummy address so that
+        // the file is still considered open
+        static const unsigned char EMPTY = 0;
+        data_ = &EMPTY;
+        return;
+    }
+
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED)
+        throw D3D12LabException("mapped file: failed to map " + filename);
+
+    data_ = static_cast<const unsigned char *>(data);
+    size_ = size;
+}
+
+bool MappedFile::isOpen() const noexcept
+{
+    return data_ != nullptr;
+}
+
+void MappedFile::close()
+{
+    if(size_)
+        munmap(const_cast<unsigned char *>(data_), size_);
+
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::adviseSequential()
+{
+    if(size_)
+        madvise(const_cast<unsigned char *>(data_), size_, MADV_SEQUENTIAL);
+}
+
+void MappedFile::prefetch(size_t offset, size_t size)
+{
+    if(offset >= size_)
+        return;
+
+    const auto [addr, len] = alignToPages(
+        data_, offset, (std::min)(size, size_ - offset));
+
+    // only a hint. failure is ignored
+    madvise(const_cast<unsigned char *>(addr), len, MADV_WILLNEED);
+}
+
+#endif
+
+const unsigned char *MappedFile::getData() const noexcept
+{
+    return data_;
+}
+
+size_t MappedFile::getSize() const noexcept
+{
+    return size_;
+}
+
+AGZ_D3D12_END
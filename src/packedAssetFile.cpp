@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+#include <d3dx12.h>
+
+#include <agz/d3d12/asset/packedAssetFile.h>
+#include <agz/d3d12/texture/formatInfo.h>
+
+AGZ_D3D12_BEGIN
+
+namespace
+{
+    struct FileHeader
+    {
+        uint32_t magic      = 0;
+        uint32_t version    = 0;
+        uint32_t entryCount = 0;
+        uint32_t reserved   = 0;
+    };
+
+    constexpr uint32_t FILE_MAGIC   = 0x505a4741; // "AGZP"
+    constexpr uint32_t FILE_VERSION = 1;
+
+    // data of each entry starts at a cache line
+    constexpr uint64_t DATA_ALIGNMENT = 64;
+
+    uint64_t alignData(uint64_t offset) noexcept
+    {
+        return (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+    }
+
+    uint64_t getSubrscSize(
+        const FormatInfo &info, uint32_t width, uint32_t height, uint32_t mip)
+    {
+        const UINT w = (std::max)(width  >> mip, 1u);
+        const UINT h = (std::max)(height >> mip, 1u);
+        return info.getRowSize(w) * info.getRowCount(h);
+    }
+
+    uint64_t getTex2DDataSize(const PackedAssetEntry &entry)
+    {
+        const FormatInfo info = getFormatInfo(DXGI_FORMAT(entry.format));
+
+        uint64_t mipChainSize = 0;
+        for(uint32_t m = 0; m < entry.mipLevels; ++m)
+            mipChainSize += getSubrscSize(info, entry.width, entry.height, m);
+
+        return mipChainSize * entry.arraySize;
+    }
+
+    uint32_t getFullMipCount(uint32_t width, uint32_t height) noexcept
+    {
+        uint32_t ret = 1;
+        for(uint32_t s = (std::max)(width, height); s > 1; s >>= 1)
+            ++ret;
+        return ret;
+    }
+
+    // checked before computing any size, so that mip shifts stay below 32
+    // and loops over subrscs are bounded
+    bool isValidTex2DLayout(
+        DXGI_FORMAT format,
+        uint32_t    width,
+        uint32_t    height,
+        uint32_t    arraySize,
+        uint32_t    mipLevels)
+    {
+        return getFormatInfo(format).bytesPerBlock &&
+               width  && width  <= D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION &&
+               height && height <= D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION &&
+               arraySize &&
+               arraySize <= D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION &&
+               mipLevels && mipLevels <= D3D12_REQ_MIP_LEVELS &&
+               mipLevels <= getFullMipCount(width, height);
+    }
+
+    bool isValidTex2D(const PackedAssetEntry &entry)
+    {
+        return isValidTex2DLayout(
+                   DXGI_FORMAT(entry.format), entry.width, entry.height,
+                   entry.arraySize, entry.mipLevels) &&
+               getTex2DDataSize(entry) == entry.size;
+    }
+
+} // namespace anonymous
+
+PackedAssetFile::PackedAssetFile(const std::string &filename)
+{
+    open(filename);
+}
+
+void PackedAssetFile::open(const std::string &filename)
+{
+    close();
+
+    misc::scope_guard_t closeGuard([&] { close(); });
+
+    file_.open(filename);
+
+    const unsigned char *data = file_.getData();
+    const uint64_t fileSize = file_.getSize();
+
+    // header & entry table
+
+    FileHeader header;
+    if(fileSize < sizeof(header))
+        throw D3D12LabException("packed asset file: invalid header");
+    std::memcpy(&header, data, sizeof(header));
+
+    if(header.magic != FILE_MAGIC || header.version != FILE_VERSION)
+        throw D3D12LabException("packed asset file: invalid header");
+
+    const uint64_t tableSize =
+        uint64_t(header.entryCount) * sizeof(PackedAssetEntry);
+    if(fileSize - sizeof(header) < tableSize)
+        throw D3D12LabException("packed asset file: truncated entry table");
+
+    entries_.resize(header.entryCount);
+    std::memcpy(entries_.data(), data + sizeof(header), tableSize);
+
+    // validate entries
+
+    for(size_t i = 0; i < entries_.size(); ++i)
+    {
+        auto &entry = entries_[i];
+        entry.name[PackedAssetEntry::MAX_NAME_LENGTH] = '\0';
+
+        if(entry.offset > fileSize || entry.size > fileSize - entry.offset)
+        {
+            throw D3D12LabException(
+                std::string("packed asset file: data out of range: ") +
+                entry.name);
+        }
+
+        if(entry.type == PackedAssetType::Texture2D && !isValidTex2D(entry))
+        {
+            throw D3D12LabException(
+                std::string("packed asset file: invalid texture: ") +
+                entry.name);
+        }
+
+        nameToEntry_[entry.name] = i;
+    }
+
+    // assets are usually streamed in order
+
+    file_.adviseSequential();
+
+    closeGuard.dismiss();
+}
+
+bool PackedAssetFile::isOpen() const noexcept
+{
+    return file_.isOpen();
+}
+
+void PackedAssetFile::close()
+{
+    file_.close();
+    entries_.clear();
+    nameToEntry_.clear();
+}
+
+size_t PackedAssetFile::getEntryCount() const noexcept
+{
+    return entries_.size();
+}
+
+const PackedAssetEntry &PackedAssetFile::getEntry(size_t index) const noexcept
+{
+    return entries_[index];
+}
+
+const PackedAssetEntry *PackedAssetFile::find(
+    const std::string &name) const noexcept
+{
+    const auto it = nameToEntry_.find(name);
+    return it != nameToEntry_.end() ? &entries_[it->second] : nullptr;
+}
+
+const unsigned char *PackedAssetFile::getData(
+    const PackedAssetEntry &entry) const noexcept
+{
+    return file_.getData() + entry.offset;
+}
+
+void PackedAssetFile::prefetch(const PackedAssetEntry &entry)
+{
+    file_.prefetch(
+        static_cast<size_t>(entry.offset), static_cast<size_t>(entry.size));
+}
+
+D3D12_RESOURCE_DESC PackedAssetFile::getTex2DDesc(
+    const PackedAssetEntry &entry,
+    D3D12_RESOURCE_FLAGS    flags) const
+{
+    assert(entry.type == PackedAssetType::Texture2D);
+    return CD3DX12_RESOURCE_DESC::Tex2D(
+        DXGI_FORMAT(entry.format), entry.width, entry.height,
+        static_cast<UINT16>(entry.arraySize),
+        static_cast<UINT16>(entry.mipLevels), 1, 0, flags);
+}
+
+std::vector<ResourceUploader::Tex2DSubInitData>
+    PackedAssetFile::getTex2DSubInitData(const PackedAssetEntry &entry) const
+{
+    assert(entry.type == PackedAssetType::Texture2D);
+
+    const FormatInfo info = getFormatInfo(DXGI_FORMAT(entry.format));
+
+    std::vector<ResourceUploader::Tex2DSubInitData> ret;
+    ret.reserve(entry.arraySize * entry.mipLevels);
+
+    const unsigned char *data = getData(entry);
+    for(uint32_t a = 0; a < entry.arraySize; ++a)
+    {
+        for(uint32_t m = 0; m < entry.mipLevels; ++m)
+        {
+            ret.emplace_back(data);
+            data += getSubrscSize(info, entry.width, entry.height, m);
+        }
+    }
+
+    return ret;
+}
+
+void PackedAssetFile::uploadBuffer(
+    ResourceUploader       &uploader,
+    const PackedAssetEntry &entry,
+    ComPtr<ID3D12Resource>  dst,
+    D3D12_RESOURCE_STATES   afterState)
+{
+    if(entry.type != PackedAssetType::Buffer)
+        throw D3D12LabException("packed asset file: entry is not a buffer");
+
+    prefetch(entry);
+    uploader.uploadBufferData(
+        std::move(dst), getData(entry),
+        static_cast<size_t>(entry.size), afterState);
+}
+
+void PackedAssetFile::uploadTex2D(
+    ResourceUploader       &uploader,
+    const PackedAssetEntry &entry,
+    ComPtr<ID3D12Resource>  dst,
+    D3D12_RESOURCE_STATES   afterState)
+{
+    if(entry.type != PackedAssetType::Texture2D)
+        throw D3D12LabException("packed asset file: entry is not a texture");
+
+    // subrsc data is laid out by entry. a mismatched dst would make the
+    // uploader read past the data of entry
+
+    const D3D12_RESOURCE_DESC dstDesc = dst->GetDesc();
+    if(dstDesc.Dimension        != D3D12_RESOURCE_DIMENSION_TEXTURE2D ||
+       dstDesc.Format           != DXGI_FORMAT(entry.format)          ||
+       dstDesc.Width            != entry.width                        ||
+       dstDesc.Height           != entry.height                       ||
+       dstDesc.DepthOrArraySize != entry.arraySize                    ||
+       dstDesc.MipLevels        != entry.mipLevels)
+    {
+        throw D3D12LabException(
+            std::string("packed asset file: texture desc mismatches entry: ") +
+            entry.name);
+    }
+
+    prefetch(entry);
+
+    const auto subrscInitData = getTex2DSubInitData(entry);
+    uploader.uploadTex2DData(
+        std::move(dst),
+        ResourceUploader::Tex2DInitData{ subrscInitData.data() },
+        afterState);
+}
+
+void PackedAssetWriter::addBuffer(
+    const std::string &name, const void *data, size_t byteSize)
+{
+    auto &entry = newEntry(name, PackedAssetType::Buffer);
+    appendData(entry, data, byteSize);
+}
+
+void PackedAssetWriter::addTex2D(
+    const std::string  &name,
+    DXGI_FORMAT         format,
+    uint32_t            width,
+    uint32_t            height,
+    uint32_t            arraySize,
+    uint32_t            mipLevels,
+    const void * const *subrscData)
+{
+    if(!isValidTex2DLayout(format, width, height, arraySize, mipLevels))
+    {
+        throw D3D12LabException(
+            "packed asset writer: invalid texture: " + name);
+    }
+
+    const FormatInfo info = getFormatInfo(format);
+
+    auto &entry = newEntry(name, PackedAssetType::Texture2D);
+    entry.format    = format;
+    entry.width     = width;
+    entry.height    = height;
+    entry.arraySize = arraySize;
+    entry.mipLevels = mipLevels;
+
+    for(uint32_t a = 0, i = 0; a < arraySize; ++a)
+    {
+        for(uint32_t m = 0; m < mipLevels; ++m, ++i)
+        {
+            const uint64_t size = getSubrscSize(info, width, height, m);
+            appendData(entry, subrscData[i], static_cast<size_t>(size));
+        }
+    }
+}
+
+void PackedAssetWriter::write(const std::string &filename) const
+{
+    std::ofstream fout(filename, std::ofstream::out | std::ofstream::binary);
+    if(!fout)
+    {
+        throw D3D12LabException(
+            "packed asset writer: failed to open " + filename);
+    }
+
+    FileHeader header;
+    header.magic      = FILE_MAGIC;
+    header.version    = FILE_VERSION;
+    header.entryCount = static_cast<uint32_t>(entries_.size());
+
+    // make entry offsets absolute
+
+    const uint64_t dataStart = alignData(
+        sizeof(header) + entries_.size() * sizeof(PackedAssetEntry));
+
+    std::vector<PackedAssetEntry> entries = entries_;
+    for(auto &e : entries)
+        e.offset += dataStart;
+
+    const uint64_t tableEnd =
+        sizeof(header) + entries.size() * sizeof(PackedAssetEntry);
+    const std::vector<char> padding(
+        static_cast<size_t>(dataStart - tableEnd), 0);
+
+    fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    fout.write(
+        reinterpret_cast<const char *>(entries.data()),
+        entries.size() * sizeof(PackedAssetEntry));
+    fout.write(padding.data(), padding.size());
+    fout.write(reinterpret_cast<const char *>(data_.data()), data_.size());
+
+    if(!fout)
+    {
+        throw D3D12LabException(
+            "packed asset writer: failed to write " + filename);
+    }
+}
+
+PackedAssetEntry &PackedAssetWriter::newEntry(
+    const std::string &name, PackedAssetType type)
+{
+    if(name.size() > PackedAssetEntry::MAX_NAME_LENGTH)
+    {
+        throw D3D12LabException(
+            "packed asset writer: name is too long: " + name);
+    }
+
+    PackedAssetEntry entry;
+    std::memcpy(entry.name, name.data(), name.size());
+    entry.type   = type;
+    entry.offset = alignData(data_.size());
+
+    data_.resize(static_cast<size_t>(entry.offset));
+    entries_.push_back(entry);
+    return entries_.back();
+}
+
+void PackedAssetWriter::appendData(
+    PackedAssetEntry &entry, const void *data, size_t size)
+{
+    auto bytes = static_cast<const unsigned char *>(data);
+    data_.insert(data_.end(), bytes, bytes + size);
+    entry.size += size;
+}
+
+AGZ_D3D12_END
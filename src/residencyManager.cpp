@@ -0,0 +1,188 @@
+#include <algorithm>
+
+#include <agz/d3d12/memory/residencyManager.h>
+
+AGZ_D3D12_BEGIN
+
+DXGIBudgetSource::DXGIBudgetSource(IDXGIAdapter *adapter)
+{
+    AGZ_D3D12_CHECK_HR_MSG(
+        "failed to query IDXGIAdapter3",
+        adapter->QueryInterface(IID_PPV_ARGS(adapter_.GetAddressOf())));
+}
+
+UINT64 DXGIBudgetSource::getBudget()
+{
+    return query().Budget;
+}
+
+UINT64 DXGIBudgetSource::getUsage()
+{
+    return query().CurrentUsage;
+}
+
+DXGI_QUERY_VIDEO_MEMORY_INFO DXGIBudgetSource::query() const
+{
+    DXGI_QUERY_VIDEO_MEMORY_INFO info;
+    AGZ_D3D12_CHECK_HR(
+        adapter_->QueryVideoMemoryInfo(
+            0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info));
+    return info;
+}
+
+ResidencyManager::ResidencyManager(
+    ComPtr<ID3D12Device>          device,
+    std::unique_ptr<BudgetSource> budgetSource)
+    : device_(std::move(device)),
+      budgetSource_(std::move(budgetSource)),
+      nextUseFenceValue_(1)
+{
+    AGZ_D3D12_CHECK_HR(
+        device_->CreateFence(
+            0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(fence_.GetAddressOf())));
+}
+
+ResidencyManager::ResidencyManager(
+    ComPtr<ID3D12Device> device, IDXGIAdapter *adapter)
+    : ResidencyManager(
+        std::move(device), std::make_unique<DXGIBudgetSource>(adapter))
+{
+
+}
+
+void ResidencyManager::track(
+    ComPtr<ID3D12Pageable> obj, UINT64 size, bool pinned)
+{
+    if(isTracked(obj.Get()))
+        return;
+
+    tracker_.add(obj.Get(), size, pinned);
+    objs_[obj.Get()] = std::move(obj);
+}
+
+void ResidencyManager::track(ComPtr<ID3D12Resource> rsc, bool pinned)
+{
+    if(isTracked(rsc.Get()))
+        return;
+
+    const auto desc = rsc->GetDesc();
+    const auto info = device_->GetResourceAllocationInfo(0, 1, &desc);
+
+    track(ComPtr<ID3D12Pageable>(std::move(rsc)), info.SizeInBytes, pinned);
+}
+
+void ResidencyManager::untrack(ID3D12Pageable *obj)
+{
+    if(isTracked(obj))
+        remove(obj);
+}
+
+bool ResidencyManager::isTracked(ID3D12Pageable *obj) const
+{
+    return objs_.find(obj) != objs_.end();
+}
+
+void ResidencyManager::pin(ID3D12Pageable *obj)
+{
+    tracker_.pin(obj);
+}
+
+void ResidencyManager::unpin(ID3D12Pageable *obj)
+{
+    tracker_.unpin(obj);
+}
+
+void ResidencyManager::use(ID3D12Pageable *obj)
+{
+    if(tracker_.use(obj, nextUseFenceValue_))
+        pendingResidentObjs_.push_back(obj);
+}
+
+void ResidencyManager::makeResident()
+{
+    if(pendingResidentObjs_.empty())
+        return;
+
+    AGZ_D3D12_CHECK_HR_MSG(
+        "failed to make objects resident",
+        device_->MakeResident(
+            static_cast<UINT>(pendingResidentObjs_.size()),
+            pendingResidentObjs_.data()));
+
+    pendingResidentObjs_.clear();
+}
+
+void ResidencyManager::addUsePoint(ID3D12CommandQueue *cmdQueue)
+{
+    AGZ_D3D12_CHECK_HR(cmdQueue->Signal(fence_.Get(), nextUseFenceValue_++));
+}
+
+void ResidencyManager::startFrame()
+{
+    untrackOrphans();
+    enforceBudget();
+}
+
+UINT64 ResidencyManager::getBudget()
+{
+    return budgetSource_->getBudget();
+}
+
+UINT64 ResidencyManager::getUsage()
+{
+    return budgetSource_->getUsage();
+}
+
+const ResidencyTracker &ResidencyManager::getTracker() const noexcept
+{
+    return tracker_;
+}
+
+void ResidencyManager::untrackOrphans()
+{
+    std::vector<ID3D12Pageable *> orphans;
+    for(auto &o : objs_)
+    {
+        o.second->AddRef();
+        if(o.second->Release() == 1)
+            orphans.push_back(o.first);
+    }
+
+    for(auto o : orphans)
+        remove(o);
+}
+
+void ResidencyManager::remove(ID3D12Pageable *obj)
+{
+    const auto pendingIt = std::find(
+        pendingResidentObjs_.begin(), pendingResidentObjs_.end(), obj);
+    if(pendingIt != pendingResidentObjs_.end())
+        pendingResidentObjs_.erase(pendingIt);
+
+    tracker_.remove(obj);
+    objs_.erase(obj);
+}
+
+void ResidencyManager::enforceBudget()
+{
+    const UINT64 usage  = budgetSource_->getUsage();
+    const UINT64 budget = budgetSource_->getBudget();
+    if(usage <= budget)
+        return;
+
+    auto evicted = tracker_.evictToBudget(
+        usage, budget, fence_->GetCompletedValue());
+    if(evicted.empty())
+        return;
+
+    std::vector<ID3D12Pageable *> objs;
+    objs.reserve(evicted.size());
+    for(auto key : evicted)
+        objs.push_back(objs_[static_cast<ID3D12Pageable *>(
+            const_cast<void *>(key))].Get());
+
+    AGZ_D3D12_CHECK_HR(
+        device_->Evict(static_cast<UINT>(objs.size()), objs.data()));
+}
+
+AGZ_D3D12_END
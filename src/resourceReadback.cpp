@@ -0,0 +1,465 @@
+#include <cstring>
+
+#include <d3dx12.h>
+
+#include <agz/d3d12/sync/resourceReadback.h>
+
+AGZ_D3D12_BEGIN
+
+namespace
+{
+    ComPtr<ID3D12CommandQueue> createCopyQueue(ID3D12Device *device)
+    {
+        D3D12_COMMAND_QUEUE_DESC copyQueueDesc = {};
+        copyQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+
+        ComPtr<ID3D12CommandQueue> copyQueue;
+        AGZ_D3D12_CHECK_HR(
+            device->CreateCommandQueue(
+                &copyQueueDesc, IID_PPV_ARGS(copyQueue.GetAddressOf())));
+
+        return copyQueue;
+    }
+
+} // namespace anonymous
+
+bool ResourceReadback::Future::isValid() const noexcept
+{
+    return state_ != nullptr;
+}
+
+bool ResourceReadback::Future::isReady() const noexcept
+{
+    return state_ && state_->isReady;
+}
+
+const ResourceReadback::Result &ResourceReadback::Future::get() const
+{
+    if(!isReady())
+        throw D3D12LabException("resource readback: result is not ready");
+    return state_->result;
+}
+
+ResourceReadback::ResourceReadback(
+    ComPtr<ID3D12Device>       device,
+    ComPtr<ID3D12CommandQueue> copyQueue,
+    ComPtr<ID3D12CommandQueue> graphicsQueue,
+    size_t                     ringCmdListCount,
+    UINT64                     ringSize)
+    : device_(std::move(device)),
+      copyQueue_(std::move(copyQueue)),
+      graphicsQueue_(std::move(graphicsQueue)),
+      curCmdListIdx_(0),
+      isCopyCmdListDirty_(false),
+      skippedReadbackCount_(0)
+{
+    misc::scope_guard_t destroyGuard([&]
+    {
+        destroyChannel(copyChannel_);
+        destroyChannel(graphicsChannel_);
+    });
+
+    initChannel(copyChannel_, ringSize);
+    initChannel(graphicsChannel_, ringSize);
+
+    cmdLists_.resize(ringCmdListCount);
+    for(auto &c : cmdLists_)
+        c.copyCmdList.initialize(device_.Get(), D3D12_COMMAND_LIST_TYPE_COPY);
+    cmdLists_[0].copyCmdList.resetCommandList();
+
+    destroyGuard.dismiss();
+}
+
+ResourceReadback::ResourceReadback(
+    Window &window,
+    size_t  ringCmdListCount,
+    UINT64  ringSize)
+    : ResourceReadback(
+        window.getDevice(),
+        createCopyQueue(window.getDevice()),
+        window.getCommandQueue(),
+        ringCmdListCount,
+        ringSize)
+{
+
+}
+
+ResourceReadback::~ResourceReadback()
+{
+    waitForIdle();
+    destroyChannel(copyChannel_);
+    destroyChannel(graphicsChannel_);
+}
+
+ResourceReadback::Future ResourceReadback::readBuffer(
+    ComPtr<ID3D12Resource> src,
+    UINT64                 offset,
+    UINT64                 byteSize,
+    Callback               callback)
+{
+    Request request;
+    request.isBuffer  = true;
+    request.srcOffset = offset;
+    request.rowSize   = byteSize;
+    request.src       = std::move(src);
+
+    allocCopyRequest(request);
+    return recordRequest(
+        cmdLists_[curCmdListIdx_].copyCmdList, copyChannel_,
+        std::move(request), std::move(callback));
+}
+
+ResourceReadback::Future ResourceReadback::readTex2D(
+    ComPtr<ID3D12Resource> src,
+    UINT                   subrsc,
+    Callback               callback)
+{
+    Request request;
+    request.isBuffer = false;
+    request.subrsc   = subrsc;
+    request.src      = std::move(src);
+
+    allocCopyRequest(request);
+    return recordRequest(
+        cmdLists_[curCmdListIdx_].copyCmdList, copyChannel_,
+        std::move(request), std::move(callback));
+}
+
+ResourceReadback::Future ResourceReadback::recordReadback(
+    ID3D12GraphicsCommandList *cmdList,
+    ComPtr<ID3D12Resource>     src,
+    UINT                       subrsc,
+    Callback                   callback)
+{
+    Request request;
+    request.isBuffer = src->GetDesc().Dimension ==
+                       D3D12_RESOURCE_DIMENSION_BUFFER;
+    request.subrsc   = subrsc;
+    request.rowSize  = request.isBuffer ? src->GetDesc().Width : 0;
+    request.src      = std::move(src);
+
+    std::lock_guard lk(graphicsMutex_);
+
+    if(!allocRequest(graphicsChannel_, request))
+    {
+        ++skippedReadbackCount_;
+        return {};
+    }
+
+    return recordRequest(
+        cmdList, graphicsChannel_, std::move(request), std::move(callback));
+}
+
+fg::PassIndex ResourceReadback::addReadbackPass(
+    fg::FrameGraph   &graph,
+    fg::ResourceIndex rsc,
+    Callback          callback,
+    UINT              subrsc)
+{
+    return graph.addComputePass(
+        [this, rsc, subrsc, callback = std::move(callback)]
+        (ID3D12GraphicsCommandList *cmdList, fg::FrameGraphPassContext &ctx)
+    {
+        recordReadback(cmdList, ctx.getResource(rsc).rsc, subrsc, callback);
+    },
+        fg::CopySource(rsc));
+}
+
+UINT64 ResourceReadback::getSkippedReadbackCount() const
+{
+    std::lock_guard lk(graphicsMutex_);
+    return skippedReadbackCount_;
+}
+
+const AllocationCounter &ResourceReadback::getRingCounter() const noexcept
+{
+    return ringCounter_;
+}
+
+void ResourceReadback::submit()
+{
+    // the graphics fence finishes recordReadback copies in executed cmd
+    // lists, and orders copies on copy queue after executed graphics work
+
+    UINT64 graphicsFenceValue;
+    {
+        std::lock_guard lk(graphicsMutex_);
+
+        graphicsFenceValue = signalGraphicsFence();
+        endChannelFrame(graphicsChannel_, graphicsFenceValue);
+    }
+
+    submitCopyCmdList(graphicsFenceValue);
+}
+
+void ResourceReadback::collect()
+{
+    resolveChannel(copyChannel_, copyChannel_.fence->GetCompletedValue());
+
+    {
+        std::lock_guard lk(graphicsMutex_);
+        resolveChannel(
+            graphicsChannel_, graphicsChannel_.fence->GetCompletedValue());
+    }
+
+    // callbacks may read back more data, so resolved requests are taken out
+    // first
+
+    auto resolvedRequests = std::move(resolvedRequests_);
+    resolvedRequests_.clear();
+
+    for(auto &request : resolvedRequests)
+        request.callback(request.state->result);
+}
+
+void ResourceReadback::waitForIdle()
+{
+    submit();
+
+    copyChannel_.fence->SetEventOnCompletion(
+        copyChannel_.nextFenceValue - 1, nullptr);
+
+    UINT64 lastGraphicsFenceValue;
+    {
+        std::lock_guard lk(graphicsMutex_);
+        lastGraphicsFenceValue = graphicsChannel_.nextFenceValue - 1;
+    }
+    graphicsChannel_.fence->SetEventOnCompletion(
+        lastGraphicsFenceValue, nullptr);
+
+    collect();
+}
+
+void ResourceReadback::initChannel(Channel &channel, UINT64 ringSize)
+{
+    ringSize =
+        (ringSize + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) /
+        D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT *
+        D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+
+    AGZ_D3D12_CHECK_HR(
+        device_->CreateCommittedResource(
+            get_temp_ptr(CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK)),
+            D3D12_HEAP_FLAG_NONE,
+            get_temp_ptr(CD3DX12_RESOURCE_DESC::Buffer(ringSize)),
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(channel.buffer.GetAddressOf())));
+
+    // readback memory stays mapped. data is read only after its fence is
+    // completed
+
+    AGZ_D3D12_CHECK_HR(
+        channel.buffer->Map(
+            0, nullptr, reinterpret_cast<void **>(&channel.data)));
+
+    channel.ring.initialize(ringSize);
+    ringCounter_.onAlloc(ringSize);
+
+    AGZ_D3D12_CHECK_HR(
+        device_->CreateFence(
+            0, D3D12_FENCE_FLAG_NONE,
+            IID_PPV_ARGS(channel.fence.GetAddressOf())));
+}
+
+void ResourceReadback::destroyChannel(Channel &channel)
+{
+    if(!channel.data)
+        return;
+
+    channel.buffer->Unmap(0, get_temp_ptr(D3D12_RANGE{ 0, 0 }));
+    channel.data = nullptr;
+
+    ringCounter_.onFree(channel.ring.getCapacity());
+}
+
+bool ResourceReadback::allocRequest(Channel &channel, Request &request)
+{
+    UINT64 byteSize;
+    if(request.isBuffer)
+    {
+        request.rowPitch = request.rowSize;
+        request.rowCount = 1;
+        byteSize         = request.rowSize;
+    }
+    else
+    {
+        const auto desc = request.src->GetDesc();
+        device_->GetCopyableFootprints(
+            &desc, request.subrsc, 1, 0, &request.footprint,
+            &request.rowCount, &request.rowSize, &byteSize);
+        request.rowPitch = request.footprint.Footprint.RowPitch;
+    }
+
+    const auto offset = channel.ring.alloc(
+        byteSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    if(!offset)
+        return false;
+
+    request.offset           = *offset;
+    request.footprint.Offset = *offset;
+    return true;
+}
+
+void ResourceReadback::allocCopyRequest(Request &request)
+{
+    for(;;)
+    {
+        if(allocRequest(copyChannel_, request))
+            return;
+
+        // space used by current cmd list can only be retired after submitting.
+        // only the copy cmd list is submitted. the graphics fence is signaled
+        // to order the copies after executed graphics work, but it does not
+        // finish recordReadback copies, whose cmd lists may not be executed
+        // yet. they are left to the next 'submit'
+
+        if(isCopyCmdListDirty_)
+        {
+            UINT64 graphicsFenceValue;
+            {
+                std::lock_guard lk(graphicsMutex_);
+                graphicsFenceValue = signalGraphicsFence();
+            }
+            submitCopyCmdList(graphicsFenceValue);
+        }
+
+        const auto oldest = copyChannel_.ring.getOldestFenceValue();
+        if(!oldest)
+        {
+            throw D3D12LabException(
+                "resource readback: readback exceeds ring size");
+        }
+
+        copyChannel_.fence->SetEventOnCompletion(*oldest, nullptr);
+        resolveChannel(copyChannel_, *oldest);
+    }
+}
+
+UINT64 ResourceReadback::signalGraphicsFence()
+{
+    const UINT64 fenceValue = graphicsChannel_.nextFenceValue++;
+    AGZ_D3D12_CHECK_HR(
+        graphicsQueue_->Signal(graphicsChannel_.fence.Get(), fenceValue));
+    return fenceValue;
+}
+
+void ResourceReadback::submitCopyCmdList(UINT64 graphicsFenceValue)
+{
+    if(!isCopyCmdListDirty_)
+        return;
+
+    auto &cur = cmdLists_[curCmdListIdx_];
+    cur.copyCmdList->Close();
+
+    ID3D12CommandList *rawCopyCmdLists[] = { cur.copyCmdList };
+
+    const UINT64 copyFenceValue = copyChannel_.nextFenceValue++;
+
+    copyQueue_->Wait(graphicsChannel_.fence.Get(), graphicsFenceValue);
+    copyQueue_->ExecuteCommandLists(1, rawCopyCmdLists);
+    AGZ_D3D12_CHECK_HR(
+        copyQueue_->Signal(copyChannel_.fence.Get(), copyFenceValue));
+
+    endChannelFrame(copyChannel_, copyFenceValue);
+    cur.expectedFenceValue = copyFenceValue;
+
+    // switch to next cmd list
+
+    curCmdListIdx_ = (curCmdListIdx_ + 1) % cmdLists_.size();
+
+    auto &next = cmdLists_[curCmdListIdx_];
+    copyChannel_.fence->SetEventOnCompletion(next.expectedFenceValue, nullptr);
+    next.copyCmdList.resetCommandList();
+
+    isCopyCmdListDirty_ = false;
+}
+
+ResourceReadback::Future ResourceReadback::recordRequest(
+    ID3D12GraphicsCommandList *cmdList,
+    Channel                   &channel,
+    Request                    request,
+    Callback                   callback)
+{
+    if(request.isBuffer)
+    {
+        cmdList->CopyBufferRegion(
+            channel.buffer.Get(), request.offset,
+            request.src.Get(), request.srcOffset, request.rowSize);
+    }
+    else
+    {
+        const CD3DX12_TEXTURE_COPY_LOCATION dstLoc(
+            channel.buffer.Get(), request.footprint);
+        const CD3DX12_TEXTURE_COPY_LOCATION srcLoc(
+            request.src.Get(), request.subrsc);
+
+        cmdList->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, nullptr);
+    }
+
+    if(&channel == &copyChannel_)
+        isCopyCmdListDirty_ = true;
+
+    Future ret;
+    ret.state_ = std::make_shared<Future::State>();
+
+    request.state    = ret.state_;
+    request.callback = std::move(callback);
+    channel.recordedRequests.push_back(std::move(request));
+
+    return ret;
+}
+
+void ResourceReadback::endChannelFrame(Channel &channel, UINT64 fenceValue)
+{
+    channel.ring.endFrame(fenceValue);
+
+    for(auto &request : channel.recordedRequests)
+    {
+        request.fenceValue = fenceValue;
+        channel.submittedRequests.push_back(std::move(request));
+    }
+    channel.recordedRequests.clear();
+}
+
+void ResourceReadback::resolveChannel(
+    Channel &channel, UINT64 completedFenceValue)
+{
+    auto &requests = channel.submittedRequests;
+    while(!requests.empty() &&
+          requests.front().fenceValue <= completedFenceValue)
+    {
+        auto request = std::move(requests.front());
+        requests.pop_front();
+
+        // drop row padding of textures
+
+        auto &result = request.state->result;
+        result.rowSize  = request.rowSize;
+        result.rowCount = request.rowCount;
+        result.data.resize(request.rowSize * request.rowCount);
+
+        const unsigned char *src = channel.data + request.offset;
+        if(request.rowPitch == request.rowSize)
+            std::memcpy(result.data.data(), src, result.data.size());
+        else
+        {
+            for(UINT r = 0; r < request.rowCount; ++r)
+            {
+                std::memcpy(
+                    result.data.data() + r * request.rowSize,
+                    src + r * request.rowPitch,
+                    request.rowSize);
+            }
+        }
+
+        request.state->isReady = true;
+
+        if(request.callback)
+            resolvedRequests_.push_back(std::move(request));
+    }
+
+    channel.ring.retire(completedFenceValue);
+}
+
+AGZ_D3D12_END
@@ -1,6 +1,12 @@
+#include <atomic>
+#include <cassert>
+#include <thread>
+
 #include <d3dx12.h>
 
+#include <agz/d3d12/asset/lz4.h>
 #include <agz/d3d12/sync/resourceUploader.h>
+#include <agz/d3d12/texture/formatInfo.h>
 
 AGZ_D3D12_BEGIN
 
@@ -18,21 +24,170 @@ namespace
 
         return copyQueue;
     }
+
+    constexpr UINT64 STAGING_BUFFER_ALIGNMENT = 16;
+
+} // namespace anonymous
+
+struct ResourceUploader::Recorder
+{
+    struct RingCmdList
+    {
+        UINT64 expectedFenceValue = 0;
+        SingleCommandList copyCmdList;
+        SingleCommandList graphicsCmdList;
+    };
+
+    struct UploadingRsc
+    {
+        UINT64 expectedFenceValue = 0;
+        ComPtr<ID3D12Resource> rsc;
+    };
+
+    ComPtr<ID3D12Resource> stagingBuffer;
+    unsigned char         *stagingData = nullptr;
+    FencedRingAllocator    stagingRing;
+
+    std::vector<RingCmdList> cmdLists;
+    size_t curCmdListIdx = 0;
+
+    bool isCopyCmdListDirty     = false;
+    bool isGraphicsCmdListDirty = false;
+
+    // post-upload transitions, recorded as one batch when submitting
+    std::vector<D3D12_RESOURCE_BARRIER> pendingBarriers;
+
+    // dsts of current cmd lists
+    std::vector<ComPtr<ID3D12Resource>> recordedRscs;
+
+    // dsts of submitted cmd lists
+    std::vector<UploadingRsc> uploadingRscs;
+
+    // fence value of the last submission
+    UINT64 lastFenceValue = 0;
+
+    RingCmdList &getCurCmdList() noexcept
+    {
+        return cmdLists[curCmdListIdx];
+    }
+
+    bool isDirty() const noexcept
+    {
+        return isCopyCmdListDirty || isGraphicsCmdListDirty ||
+               !pendingBarriers.empty();
+    }
+};
+
+ResourceUploader::ThreadContext::ThreadContext(
+    ResourceUploader &uploader,
+    size_t            ringCmdListCount,
+    UINT64            stagingRingSize)
+    : uploader_(uploader),
+      recorder_(std::make_unique<Recorder>())
+{
+    uploader_.initRecorder(*recorder_, ringCmdListCount, stagingRingSize);
+}
+
+ResourceUploader::ThreadContext::~ThreadContext()
+{
+    waitForIdle();
+    uploader_.destroyRecorder(*recorder_);
+}
+
+void ResourceUploader::ThreadContext::uploadBufferData(
+    ComPtr<ID3D12Resource> dst,
+    const void            *data,
+    size_t                 byteSize,
+    D3D12_RESOURCE_STATES  afterState)
+{
+    uploader_.copyBufferData(*recorder_, dst.Get(), 0, data, byteSize);
+    recordTransition(*recorder_, dst.Get(), afterState);
+    addUploadingRsc(*recorder_, std::move(dst));
+}
+
+void ResourceUploader::ThreadContext::uploadBufferData(
+    const BufferRange &dst,
+    const void        *data,
+    size_t             byteSize)
+{
+    assert(byteSize <= dst.size);
+    uploader_.copyBufferData(
+        *recorder_, dst.resource, dst.offset, data, byteSize);
+}
+
+void ResourceUploader::ThreadContext::uploadTex2DData(
+    ComPtr<ID3D12Resource> dst,
+    const Tex2DInitData   &initData,
+    D3D12_RESOURCE_STATES  afterState)
+{
+    uploader_.copyTex2DData(*recorder_, dst.Get(), initData);
+    recordTransition(*recorder_, dst.Get(), afterState);
+    addUploadingRsc(*recorder_, std::move(dst));
+}
+
+void ResourceUploader::ThreadContext::uploadTex2DRegions(
+    ComPtr<ID3D12Resource> dst,
+    const Tex2DRegionData *regions,
+    size_t                 regionCount,
+    D3D12_RESOURCE_STATES  afterState)
+{
+    const auto dstDesc = dst->GetDesc();
+    for(size_t i = 0; i < regionCount; ++i)
+        uploader_.copyTex2DRegion(*recorder_, dst.Get(), dstDesc, regions[i]);
+
+    recordTransition(*recorder_, dst.Get(), afterState);
+    addUploadingRsc(*recorder_, std::move(dst));
+}
+
+void ResourceUploader::ThreadContext::uploadCompressedBufferData(
+    ComPtr<ID3D12Resource> dst,
+    const ChunkedLZ4View  &src,
+    D3D12_RESOURCE_STATES  afterState)
+{
+    uploader_.copyCompressedBufferData(*recorder_, dst.Get(), 0, src, false);
+    recordTransition(*recorder_, dst.Get(), afterState);
+    addUploadingRsc(*recorder_, std::move(dst));
+}
+
+UINT64 ResourceUploader::ThreadContext::submit()
+{
+    if(recorder_->isDirty())
+        return uploader_.submitRecorder(*recorder_);
+    return recorder_->lastFenceValue;
+}
+
+bool ResourceUploader::ThreadContext::isFinished(UINT64 fenceValue) const
+{
+    return uploader_.finishFence_->GetCompletedValue() >= fenceValue;
+}
+
+void ResourceUploader::ThreadContext::collect()
+{
+    retireRecorder(*recorder_, uploader_.finishFence_->GetCompletedValue());
+}
+
+void ResourceUploader::ThreadContext::waitForIdle()
+{
+    const UINT64 fenceValue = submit();
+    uploader_.finishFence_->SetEventOnCompletion(fenceValue, nullptr);
+    retireRecorder(*recorder_, fenceValue);
 }
 
 ResourceUploader::ResourceUploader(
     ComPtr<ID3D12Device>       device,
     ComPtr<ID3D12CommandQueue> copyQueue,
     ComPtr<ID3D12CommandQueue> graphicsQueue,
-    size_t                     ringCmdListCount)
+    size_t                     ringCmdListCount,
+    UINT64                     stagingRingSize)
     : device_(std::move(device)),
       copyQueue_(std::move(copyQueue)),
       graphicsQueue_(std::move(graphicsQueue)),
       nextExpectedCopyToGraphicsFenceValue_(1),
       nextExpectedFinishFenceValue_(1),
-      curCmdListIdx_(0),
-      isCurCmdListDirty_(false),
-      isCurGraphicsCmdListDirty_(false)
+      decompressThreadCount_(0),
+      nextTicket_(1),
+      asyncBytesPerCall_(UINT64(8) << 20),
+      residencyMgr_(nullptr)
 {
     AGZ_D3D12_CHECK_HR(
         device_->CreateFence(
@@ -44,41 +199,31 @@ ResourceUploader::ResourceUploader(
             0, D3D12_FENCE_FLAG_NONE,
             IID_PPV_ARGS(finishFence_.GetAddressOf())));
 
-    copyCmdLists_.resize(ringCmdListCount);
-    graphicsCmdLists_.resize(ringCmdListCount);
-
-    for(auto &c : copyCmdLists_)
-    {
-        c.expectedFenceValue = 0;
-        c.cmdList.initialize(device_.Get(), D3D12_COMMAND_LIST_TYPE_COPY);
-    }
-    copyCmdLists_[0].cmdList.resetCommandList();
+    mainRecorder_ = std::make_unique<Recorder>();
+    initRecorder(*mainRecorder_, ringCmdListCount, stagingRingSize);
 
-    for(auto &c : graphicsCmdLists_)
-    {
-        c.expectedFenceValue = 0;
-        c.cmdList.initialize(device_.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
-    }
-    graphicsCmdLists_[0].cmdList.resetCommandList();
+    setDecompressionThreadCount(
+        static_cast<int>(std::thread::hardware_concurrency()));
 }
 
 ResourceUploader::ResourceUploader(
     Window &window,
-    size_t  ringCmdListCount)
+    size_t  ringCmdListCount,
+    UINT64  stagingRingSize)
     : ResourceUploader(
         window.getDevice(),
         createCopyQueue(window.getDevice()),
         window.getCommandQueue(),
-        ringCmdListCount)
+        ringCmdListCount,
+        stagingRingSize)
 {
 
 }
 
 ResourceUploader::~ResourceUploader()
 {
-    if(isCurCmdListDirty_)
-        submit();
     waitForIdle();
+    destroyRecorder(*mainRecorder_);
 }
 
 void ResourceUploader::uploadBufferData(
@@ -87,44 +232,10 @@ void ResourceUploader::uploadBufferData(
     size_t                 byteSize,
     D3D12_RESOURCE_STATES  afterState)
 {
-    const auto uploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-    const auto uploadDesc      = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
-
-    ComPtr<ID3D12Resource> uploadBuf;
-    AGZ_D3D12_CHECK_HR(
-        device_->CreateCommittedResource(
-            &uploadHeapProps, D3D12_HEAP_FLAG_NONE, &uploadDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
-            IID_PPV_ARGS(uploadBuf.GetAddressOf())));
-
-    auto &copyC     = copyCmdLists_[curCmdListIdx_];
-    auto &graphicsC = graphicsCmdLists_[curCmdListIdx_];
-
-    D3D12_SUBRESOURCE_DATA subrscData;
-    subrscData.pData      = data;
-    subrscData.RowPitch   = byteSize;
-    subrscData.SlicePitch = byteSize;
-
-    UpdateSubresources(
-        copyC.cmdList, dst.Get(), uploadBuf.Get(), 0, 0, 1, &subrscData);
-
-    if(afterState != D3D12_RESOURCE_STATE_COMMON)
-    {
-        graphicsC.cmdList->ResourceBarrier(
-            1, get_temp_ptr(CD3DX12_RESOURCE_BARRIER::Transition(
-                dst.Get(), D3D12_RESOURCE_STATE_COMMON, afterState)));
-
-        isCurGraphicsCmdListDirty_ = true;
-    }
-
-    UploadingRsc rcd;
-    rcd.expectedFenceValue = nextExpectedFinishFenceValue_;
-    rcd.upload             = uploadBuf;
-    rcd.rsc                = dst;
-
-    uploadingRscs_.push_back(std::move(rcd));
-
-    isCurCmdListDirty_ = true;
+    useResidency(dst);
+    copyBufferData(*mainRecorder_, dst.Get(), 0, data, byteSize);
+    recordTransition(*mainRecorder_, dst.Get(), afterState);
+    addUploadingRsc(*mainRecorder_, std::move(dst));
 }
 
 void ResourceUploader::uploadBufferData(
@@ -144,6 +255,18 @@ void ResourceUploader::uploadBufferData(
     uploadBufferData(buffer, data, buffer.getTotalByteSize(), afterState);
 }
 
+void ResourceUploader::uploadBufferData(
+    const BufferRange &dst,
+    const void        *data,
+    size_t             byteSize)
+{
+    assert(byteSize <= dst.size);
+
+    useResidency(dst.resource);
+    copyBufferData(*mainRecorder_, dst.resource, dst.offset, data, byteSize);
+    addUploadingRsc(*mainRecorder_, dst.resource);
+}
+
 void ResourceUploader::uploadTex2DData(
     ComPtr<ID3D12Resource>  dst,
     const Tex2DSubInitData &initData,
@@ -157,178 +280,842 @@ void ResourceUploader::uploadTex2DData(
     const Tex2DInitData   &initData,
     D3D12_RESOURCE_STATES  afterState)
 {
+    useResidency(dst);
+    copyTex2DData(*mainRecorder_, dst.Get(), initData);
+    recordTransition(*mainRecorder_, dst.Get(), afterState);
+    addUploadingRsc(*mainRecorder_, std::move(dst));
+}
+
+void ResourceUploader::uploadTex2DRegion(
+    ComPtr<ID3D12Resource> dst,
+    const Tex2DRegionData &region,
+    D3D12_RESOURCE_STATES  afterState)
+{
+    uploadTex2DRegions(std::move(dst), &region, 1, afterState);
+}
+
+void ResourceUploader::uploadTex2DRegions(
+    ComPtr<ID3D12Resource> dst,
+    const Tex2DRegionData *regions,
+    size_t                 regionCount,
+    D3D12_RESOURCE_STATES  afterState)
+{
+    useResidency(dst);
+
     const auto dstDesc = dst->GetDesc();
+    for(size_t i = 0; i < regionCount; ++i)
+        copyTex2DRegion(*mainRecorder_, dst.Get(), dstDesc, regions[i]);
 
-    // texel size
+    recordTransition(*mainRecorder_, dst.Get(), afterState);
+    addUploadingRsc(*mainRecorder_, std::move(dst));
+}
+
+void ResourceUploader::uploadCompressedBufferData(
+    ComPtr<ID3D12Resource> dst,
+    const ChunkedLZ4View  &src,
+    D3D12_RESOURCE_STATES  afterState)
+{
+    useResidency(dst);
+    copyCompressedBufferData(*mainRecorder_, dst.Get(), 0, src, true);
+    recordTransition(*mainRecorder_, dst.Get(), afterState);
+    addUploadingRsc(*mainRecorder_, std::move(dst));
+}
 
-    UINT texelSize;
-    switch(dstDesc.Format)
+void ResourceUploader::uploadCompressedBufferData(
+    const BufferRange    &dst,
+    const ChunkedLZ4View &src)
+{
+    assert(src.getDecompressedSize() <= dst.size);
+
+    useResidency(dst.resource);
+    copyCompressedBufferData(
+        *mainRecorder_, dst.resource, dst.offset, src, true);
+    addUploadingRsc(*mainRecorder_, dst.resource);
+}
+
+void ResourceUploader::setDecompressionThreadCount(int threadCount)
+{
+    decompressThreadCount_ = (std::max)(threadCount, 1);
+    decompressThreadGroup_ =
+        std::make_unique<thread::thread_group_t>(decompressThreadCount_);
+}
+
+ResourceUploader::UploadTicket ResourceUploader::uploadBufferDataAsync(
+    ComPtr<ID3D12Resource> dst,
+    const void            *data,
+    size_t                 byteSize,
+    D3D12_RESOURCE_STATES  afterState,
+    int                    priority,
+    UploadCallback         callback)
+{
+    AsyncUpload upload;
+    upload.byteSize = byteSize;
+    upload.callback = std::move(callback);
+    upload.record   = [=, dst = std::move(dst)]
     {
-    case DXGI_FORMAT_R8G8B8A8_UNORM:     texelSize = 4;  break;
-    case DXGI_FORMAT_R32G32B32_FLOAT:    texelSize = 12; break;
-    case DXGI_FORMAT_R32G32B32A32_FLOAT: texelSize = 16; break;
-    default:
-        throw D3D12LabException(
-            "resource uploader: unsupported texel format");
-    }
+        uploadBufferData(dst, data, byteSize, afterState);
+    };
 
-    // construct D3D12_SUBRESOURCE_DATAs
+    return queueAsyncUpload(priority, std::move(upload));
+}
+
+ResourceUploader::UploadTicket ResourceUploader::uploadTex2DDataAsync(
+    ComPtr<ID3D12Resource> dst,
+    const Tex2DInitData   &initData,
+    D3D12_RESOURCE_STATES  afterState,
+    int                    priority,
+    UploadCallback         callback)
+{
+    const auto desc = dst->GetDesc();
+    const UINT subrscCount = desc.DepthOrArraySize * desc.MipLevels;
 
-    const UINT arraySize   = dstDesc.DepthOrArraySize;
-    const UINT mipmapCount = dstDesc.MipLevels;
+    // subrsc descs are copied. the pointed data is not
 
-    const UINT width  = static_cast<UINT>(dstDesc.Width);
-    const UINT height = static_cast<UINT>(dstDesc.Height);
+    std::vector<Tex2DSubInitData> subrscInitData(
+        initData.subrscInitData, initData.subrscInitData + subrscCount);
 
-    std::vector<D3D12_SUBRESOURCE_DATA> allSubrscData;
-    allSubrscData.reserve(arraySize * mipmapCount);
+    UINT64 byteSize;
+    device_->GetCopyableFootprints(
+        &desc, 0, subrscCount, 0, nullptr, nullptr, nullptr, &byteSize);
 
-    for(UINT arrIdx = 0; arrIdx < arraySize; ++arrIdx)
+    AsyncUpload upload;
+    upload.byteSize = byteSize;
+    upload.callback = std::move(callback);
+    upload.record   = [=, dst = std::move(dst),
+                          subrscInitData = std::move(subrscInitData)]
     {
-        for(UINT mipIdx = 0; mipIdx < mipmapCount; ++mipIdx)
-        {
-            const UINT subrscIdx = arrIdx * mipmapCount + mipIdx;
-            const auto &iData = initData.subrscInitData[subrscIdx];
+        uploadTex2DData(
+            dst, Tex2DInitData{ subrscInitData.data() }, afterState);
+    };
 
-            const UINT mipWidth  = (std::max<UINT>)(1, width >> mipIdx);
-            const UINT mipHeight = (std::max<UINT>)(1, height >> mipIdx);
+    return queueAsyncUpload(priority, std::move(upload));
+}
 
-            const UINT initDataRowSize = iData.rowSize ?
-                                         static_cast<UINT>(iData.rowSize) :
-                                         (texelSize * mipWidth);
+void ResourceUploader::setAsyncBytesPerCall(UINT64 bytes) noexcept
+{
+    asyncBytesPerCall_ = bytes;
+}
 
-            D3D12_SUBRESOURCE_DATA subrscData;
-            subrscData.pData      = iData.data;
-            subrscData.RowPitch   = initDataRowSize;
-            subrscData.SlicePitch = initDataRowSize * mipHeight;
+void ResourceUploader::processAsyncUploads()
+{
+    if(queuedAsyncUploads_.empty())
+        return;
+
+    const size_t firstInflightIdx = inflightAsyncUploads_.size();
+
+    // recording may submit cmds in the middle. all recorded copies are
+    // finished with the fence value of the following submission
+
+    auto submitRecorded = [&]
+    {
+        const UINT64 fenceValue = submitRecorder(*mainRecorder_);
+        for(size_t i = firstInflightIdx; i < inflightAsyncUploads_.size(); ++i)
+            inflightAsyncUploads_[i].expectedFenceValue = fenceValue;
+    };
 
-            allSubrscData.push_back(subrscData);
+    UINT64 recordedBytes = 0;
+    while(!queuedAsyncUploads_.empty())
+    {
+        auto it = queuedAsyncUploads_.begin();
+        if(recordedBytes &&
+           recordedBytes + it->second.byteSize > asyncBytesPerCall_)
+            break;
+
+        // a failed upload is dropped and its ticket is finished without
+        // invoking its callback. copies recorded before, including partial
+        // ones of the failed upload, are still submitted, so that no ticket
+        // or staging space waits for a fence value never signaled
+
+        try
+        {
+            it->second.record();
+        }
+        catch(...)
+        {
+            unfinishedTickets_.erase(it->first.second);
+            queuedAsyncUploads_.erase(it);
+            submitRecorded();
+            throw;
         }
+
+        recordedBytes += it->second.byteSize;
+
+        InflightAsyncUpload inflight;
+        inflight.ticket   = it->first.second;
+        inflight.callback = std::move(it->second.callback);
+        inflightAsyncUploads_.push_back(std::move(inflight));
+
+        queuedAsyncUploads_.erase(it);
     }
 
-    // create upload heap
+    submitRecorded();
+}
+
+bool ResourceUploader::isFinished(UploadTicket ticket) const noexcept
+{
+    return ticket < nextTicket_ && !unfinishedTickets_.count(ticket);
+}
+
+size_t ResourceUploader::getQueuedAsyncUploadCount() const noexcept
+{
+    return queuedAsyncUploads_.size();
+}
+
+void ResourceUploader::setResidencyManager(ResidencyManager *residencyMgr)
+{
+    residencyMgr_ = residencyMgr;
+}
+
+const AllocationCounter &ResourceUploader::getStagingCounter() const noexcept
+{
+    return stagingCounter_;
+}
+
+std::unique_ptr<ResourceUploader::ThreadContext>
+    ResourceUploader::createThreadContext(
+        UINT64 stagingRingSize, size_t ringCmdListCount)
+{
+    return std::unique_ptr<ThreadContext>(
+        new ThreadContext(*this, ringCmdListCount, stagingRingSize));
+}
+
+void ResourceUploader::submit()
+{
+    submitRecorder(*mainRecorder_);
+}
+
+void ResourceUploader::collect()
+{
+    trackPendingResidency();
+
+    const UINT64 completedValue = finishFence_->GetCompletedValue();
 
-    ComPtr<ID3D12Resource> uploadBuf;
+    retireRecorder(*mainRecorder_, completedValue);
+    unpinFinishedRscs(completedValue);
 
-    const UINT64 uploadBufSize = GetRequiredIntermediateSize(
-        dst.Get(), 0, arraySize * mipmapCount);
+    // callbacks may queue new uploads, so the front is popped first
+
+    while(!inflightAsyncUploads_.empty() &&
+          inflightAsyncUploads_.front().expectedFenceValue <= completedValue)
+    {
+        auto inflight = std::move(inflightAsyncUploads_.front());
+        inflightAsyncUploads_.pop_front();
+
+        unfinishedTickets_.erase(inflight.ticket);
+        if(inflight.callback)
+            inflight.callback();
+    }
+}
+
+void ResourceUploader::waitForIdle()
+{
+    if(mainRecorder_->isDirty())
+        submit();
+
+    UINT64 lastFenceValue;
+    {
+        std::lock_guard lk(submitMutex_);
+        lastFenceValue = nextExpectedFinishFenceValue_ - 1;
+    }
+    finishFence_->SetEventOnCompletion(lastFenceValue, nullptr);
+
+    collect();
+}
+
+ResourceUploader::UploadTicket ResourceUploader::queueAsyncUpload(
+    int priority, AsyncUpload upload)
+{
+    const UploadTicket ticket = nextTicket_++;
+    queuedAsyncUploads_.insert({ { -priority, ticket }, std::move(upload) });
+    unfinishedTickets_.insert(ticket);
+    return ticket;
+}
+
+void ResourceUploader::initRecorder(
+    Recorder &recorder, size_t ringCmdListCount, UINT64 stagingRingSize)
+{
+    // staging ring
+
+    stagingRingSize =
+        (stagingRingSize + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) /
+        D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT *
+        D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
 
     AGZ_D3D12_CHECK_HR(
         device_->CreateCommittedResource(
             get_temp_ptr(CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD)),
             D3D12_HEAP_FLAG_NONE,
-            get_temp_ptr(CD3DX12_RESOURCE_DESC::Buffer(uploadBufSize)),
-            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
-            IID_PPV_ARGS(uploadBuf.GetAddressOf())));
+            get_temp_ptr(CD3DX12_RESOURCE_DESC::Buffer(stagingRingSize)),
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(recorder.stagingBuffer.GetAddressOf())));
 
-    // upload data
+    D3D12_RANGE readRange = { 0, 0 };
+    AGZ_D3D12_CHECK_HR(
+        recorder.stagingBuffer->Map(
+            0, &readRange, reinterpret_cast<void **>(&recorder.stagingData)));
 
-    UpdateSubresources(
-        copyCmdLists_[curCmdListIdx_].cmdList, dst.Get(), uploadBuf.Get(),
-        0, 0, arraySize * mipmapCount, allSubrscData.data());
+    recorder.stagingRing.initialize(stagingRingSize);
+    stagingCounter_.onAlloc(stagingRingSize);
 
-    // barrier
+    // cmd lists
 
-    if(afterState != D3D12_RESOURCE_STATE_COMMON)
+    recorder.cmdLists.resize(ringCmdListCount);
+    for(auto &c : recorder.cmdLists)
     {
-        graphicsCmdLists_[curCmdListIdx_].cmdList->ResourceBarrier(
-            1, get_temp_ptr(CD3DX12_RESOURCE_BARRIER::Transition(
-                dst.Get(), D3D12_RESOURCE_STATE_COMMON, afterState)));
+        c.copyCmdList.initialize(device_.Get(), D3D12_COMMAND_LIST_TYPE_COPY);
+        c.graphicsCmdList.initialize(
+            device_.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
+    }
+    recorder.cmdLists[0].copyCmdList.resetCommandList();
+    recorder.cmdLists[0].graphicsCmdList.resetCommandList();
+}
+
+void ResourceUploader::destroyRecorder(Recorder &recorder)
+{
+    recorder.stagingBuffer->Unmap(0, nullptr);
+    stagingCounter_.onFree(recorder.stagingRing.getCapacity());
+}
 
-        isCurGraphicsCmdListDirty_ = true;
+UINT64 ResourceUploader::allocStaging(
+    Recorder &recorder, UINT64 size, UINT64 alignment)
+{
+    for(;;)
+    {
+        if(auto offset = recorder.stagingRing.alloc(size, alignment))
+            return *offset;
+
+        // space used by current cmd lists can only be retired after submitting
+
+        if(recorder.isCopyCmdListDirty)
+            submitRecorder(recorder);
+
+        const auto oldest = recorder.stagingRing.getOldestFenceValue();
+        if(!oldest)
+        {
+            throw D3D12LabException(
+                "resource uploader: staging allocation exceeds ring size");
+        }
+
+        finishFence_->SetEventOnCompletion(*oldest, nullptr);
+        recorder.stagingRing.retire(*oldest);
     }
+}
 
-    UploadingRsc rcd;
-    rcd.rsc                = dst;
-    rcd.upload             = uploadBuf;
-    rcd.expectedFenceValue = nextExpectedFinishFenceValue_;
+UINT64 ResourceUploader::getMaxStagingChunkSize(
+    const Recorder &recorder) noexcept
+{
+    // half of the ring always fits after waiting for all submissions, either
+    // before or after the current position
+    const UINT64 half = recorder.stagingRing.getCapacity() / 2;
+    return half / D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT *
+           D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+}
 
-    uploadingRscs_.push_back(rcd);
+void ResourceUploader::copyBufferData(
+    Recorder       &recorder,
+    ID3D12Resource *dst,
+    UINT64          dstOffset,
+    const void     *data,
+    UINT64          byteSize)
+{
+    auto src = static_cast<const unsigned char *>(data);
+    const UINT64 maxChunkSize = getMaxStagingChunkSize(recorder);
 
-    isCurCmdListDirty_ = true;
+    for(UINT64 copied = 0; copied < byteSize;)
+    {
+        const UINT64 chunkSize = (std::min)(maxChunkSize, byteSize - copied);
+        const UINT64 offset = allocStaging(
+            recorder, chunkSize, STAGING_BUFFER_ALIGNMENT);
+
+        std::memcpy(recorder.stagingData + offset, src + copied, chunkSize);
+
+        recorder.getCurCmdList().copyCmdList->CopyBufferRegion(
+            dst, dstOffset + copied,
+            recorder.stagingBuffer.Get(), offset, chunkSize);
+
+        recorder.isCopyCmdListDirty = true;
+        copied += chunkSize;
+    }
 }
 
-void ResourceUploader::submit()
+void ResourceUploader::copyTex2DData(
+    Recorder            &recorder,
+    ID3D12Resource      *dst,
+    const Tex2DInitData &initData)
 {
-    // submit current cmd lists
+    const auto dstDesc = dst->GetDesc();
+
+    // subrscs of multi-plane formats (e.g. depth and stencil) are not
+    // indexed by mip and array slice only
+
+    const FormatInfo formatInfo = getFormatInfo(dstDesc.Format);
+    if(!formatInfo.bytesPerBlock || formatInfo.planeCount > 1)
+    {
+        throw D3D12LabException(
+            "resource uploader: unsupported texture format");
+    }
 
-    ID3D12CommandList *rawCopyCmdLists[] =
-        { copyCmdLists_[curCmdListIdx_].cmdList };
-    ID3D12CommandList *rawGraphicsCmdLists[] =
-        { graphicsCmdLists_[curCmdListIdx_].cmdList };
+    // copy subrscs row by row. a subrsc larger than max chunk size is
+    // split into multiple copies of consecutive rows. a row contains
+    // blockHeight texel rows
 
-    copyCmdLists_    [curCmdListIdx_].cmdList->Close();
-    graphicsCmdLists_[curCmdListIdx_].cmdList->Close();
+    const UINT   subrscCount  = dstDesc.DepthOrArraySize * dstDesc.MipLevels;
+    const UINT64 maxChunkSize = getMaxStagingChunkSize(recorder);
 
-    if(isCurGraphicsCmdListDirty_)
+    for(UINT subrscIdx = 0; subrscIdx < subrscCount; ++subrscIdx)
     {
-        copyQueue_->ExecuteCommandLists(1, rawCopyCmdLists);
-        copyQueue_->Signal(
-            copyToGraphicsFence_.Get(), nextExpectedCopyToGraphicsFenceValue_);
-
-        graphicsQueue_->Wait(
-            copyToGraphicsFence_.Get(), nextExpectedCopyToGraphicsFenceValue_++);
-        graphicsQueue_->ExecuteCommandLists(1, rawGraphicsCmdLists);
-        graphicsQueue_->Signal(
-            finishFence_.Get(), nextExpectedFinishFenceValue_++);
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+        UINT   rowCount;
+        UINT64 rowSize;
+        device_->GetCopyableFootprints(
+            &dstDesc, subrscIdx, 1, 0,
+            &footprint, &rowCount, &rowSize, nullptr);
+
+        const UINT64 rowPitch = footprint.Footprint.RowPitch;
+        if(rowPitch > maxChunkSize)
+        {
+            throw D3D12LabException(
+                "resource uploader: texture row exceeds staging ring");
+        }
+
+        const auto &iData = initData.subrscInitData[subrscIdx];
+        const UINT64 srcRowPitch = iData.rowSize ? iData.rowSize : rowSize;
+        auto srcData = static_cast<const unsigned char *>(iData.data);
+
+        const UINT rowsPerChunk = static_cast<UINT>(maxChunkSize / rowPitch);
+        const UINT rowHeight    = formatInfo.blockHeight;
+
+        for(UINT rowBeg = 0; rowBeg < rowCount; rowBeg += rowsPerChunk)
+        {
+            const UINT rows = (std::min)(rowsPerChunk, rowCount - rowBeg);
+
+            const UINT64 offset = allocStaging(
+                recorder, rows * rowPitch,
+                D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+            for(UINT r = 0; r < rows; ++r)
+            {
+                std::memcpy(
+                    recorder.stagingData + offset + r * rowPitch,
+                    srcData + (rowBeg + r) * srcRowPitch,
+                    rowSize);
+            }
+
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT chunkFootprint = footprint;
+            chunkFootprint.Offset           = offset;
+            chunkFootprint.Footprint.Height = rows * rowHeight;
+
+            const CD3DX12_TEXTURE_COPY_LOCATION dstLoc(dst, subrscIdx);
+            const CD3DX12_TEXTURE_COPY_LOCATION srcLoc(
+                recorder.stagingBuffer.Get(), chunkFootprint);
+
+            recorder.getCurCmdList().copyCmdList->CopyTextureRegion(
+                &dstLoc, 0, rowBeg * rowHeight, 0, &srcLoc, nullptr);
+
+            recorder.isCopyCmdListDirty = true;
+        }
+    }
+}
+
+void ResourceUploader::copyTex2DRegion(
+    Recorder                  &recorder,
+    ID3D12Resource            *dst,
+    const D3D12_RESOURCE_DESC &dstDesc,
+    const Tex2DRegionData     &region)
+{
+    // subrscs of multi-plane formats (e.g. depth and stencil) are not
+    // indexed by mip and array slice only
+
+    const FormatInfo formatInfo = getFormatInfo(dstDesc.Format);
+    if(!formatInfo.bytesPerBlock || formatInfo.planeCount > 1)
+    {
+        throw D3D12LabException(
+            "resource uploader: unsupported texture format");
+    }
+
+    // validate box
+
+    const UINT mipLevel = region.subrsc % dstDesc.MipLevels;
+    const UINT mipWidth = (std::max)(
+        static_cast<UINT>(dstDesc.Width >> mipLevel), 1u);
+    const UINT mipHeight = (std::max)(dstDesc.Height >> mipLevel, 1u);
+
+    const D3D12_BOX &box = region.box;
+    const UINT bw = formatInfo.blockWidth;
+    const UINT bh = formatInfo.blockHeight;
+
+    if(region.subrsc >= dstDesc.MipLevels * dstDesc.DepthOrArraySize ||
+       box.left >= box.right || box.top >= box.bottom ||
+       box.right > mipWidth || box.bottom > mipHeight)
+    {
+        throw D3D12LabException(
+            "resource uploader: texture region out of range");
     }
-    else
+
+    if(box.left % bw || box.top % bh ||
+       (box.right  % bw && box.right  != mipWidth) ||
+       (box.bottom % bh && box.bottom != mipHeight))
     {
-        copyQueue_->ExecuteCommandLists(1, rawCopyCmdLists);
-        copyQueue_->Signal(
-            finishFence_.Get(), nextExpectedFinishFenceValue_++);
+        throw D3D12LabException(
+            "resource uploader: texture region is not block-aligned");
     }
 
+    // stage rows of the box at pitch alignment, split into chunks like
+    // whole subrscs
+
+    const UINT width  = box.right  - box.left;
+    const UINT height = box.bottom - box.top;
+
+    const UINT64 rowSize  = formatInfo.getRowSize(width);
+    const UINT   rowCount = formatInfo.getRowCount(height);
+    const UINT64 rowPitch =
+        (rowSize + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) /
+        D3D12_TEXTURE_DATA_PITCH_ALIGNMENT * D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+
+    const UINT64 maxChunkSize = getMaxStagingChunkSize(recorder);
+    if(rowPitch > maxChunkSize)
+    {
+        throw D3D12LabException(
+            "resource uploader: texture row exceeds staging ring");
+    }
+
+    const UINT64 srcRowPitch = region.rowSize ? region.rowSize : rowSize;
+    auto srcData = static_cast<const unsigned char *>(region.data);
+
+    const UINT rowsPerChunk = static_cast<UINT>(maxChunkSize / rowPitch);
+
+    for(UINT rowBeg = 0; rowBeg < rowCount; rowBeg += rowsPerChunk)
+    {
+        const UINT rows = (std::min)(rowsPerChunk, rowCount - rowBeg);
+
+        const UINT64 offset = allocStaging(
+            recorder, rows * rowPitch, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+        for(UINT r = 0; r < rows; ++r)
+        {
+            std::memcpy(
+                recorder.stagingData + offset + r * rowPitch,
+                srcData + (rowBeg + r) * srcRowPitch,
+                rowSize);
+        }
+
+        // footprint covers whole blocks like GetCopyableFootprints, even when
+        // the box is cut by the right or bottom edge of a block-compressed
+        // mip whose size is not a multiple of block size
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+        footprint.Offset             = offset;
+        footprint.Footprint.Format   = dstDesc.Format;
+        footprint.Footprint.Width    = (width + bw - 1) / bw * bw;
+        footprint.Footprint.Height   = rows * bh;
+        footprint.Footprint.Depth    = 1;
+        footprint.Footprint.RowPitch = static_cast<UINT>(rowPitch);
+
+        const CD3DX12_TEXTURE_COPY_LOCATION dstLoc(dst, region.subrsc);
+        const CD3DX12_TEXTURE_COPY_LOCATION srcLoc(
+            recorder.stagingBuffer.Get(), footprint);
+
+        recorder.getCurCmdList().copyCmdList->CopyTextureRegion(
+            &dstLoc, box.left, box.top + rowBeg * bh, 0, &srcLoc, nullptr);
+
+        recorder.isCopyCmdListDirty = true;
+    }
+}
+
+void ResourceUploader::copyCompressedBufferData(
+    Recorder             &recorder,
+    ID3D12Resource       *dst,
+    UINT64                dstOffset,
+    const ChunkedLZ4View &src,
+    bool                  parallel)
+{
+    const uint32_t chunkCount = src.getChunkCount();
+    if(!chunkCount)
+        return;
+
+    // the declared chunk size, not the size of the first chunk, decides the
+    // number of chunks per copy. a short single chunk may be smaller
+
+    const uint32_t chunkSize    = src.getChunkSize();
+    const UINT64   maxChunkSize = getMaxStagingChunkSize(recorder);
+    if(chunkSize > maxChunkSize)
+    {
+        throw D3D12LabException(
+            "resource uploader: compressed chunk exceeds staging ring");
+    }
+
+    // decompress each group of chunks into one staging allocation and copy
+    // it with one CopyBufferRegion
+
+    const uint32_t chunksPerCopy = static_cast<uint32_t>(
+        (std::min)(maxChunkSize / chunkSize, UINT64(chunkCount)));
+    assert(chunksPerCopy >= 1);
+
+    for(uint32_t chunkBeg = 0; chunkBeg < chunkCount; chunkBeg += chunksPerCopy)
+    {
+        const uint32_t chunkEnd =
+            (std::min)(chunkBeg + chunksPerCopy, chunkCount);
+
+        const UINT64 byteBeg = UINT64(chunkBeg) * chunkSize;
+        const UINT64 byteEnd = (std::min)(
+            UINT64(chunkEnd) * chunkSize, src.getDecompressedSize());
+
+        const UINT64 offset = allocStaging(
+            recorder, byteEnd - byteBeg, STAGING_BUFFER_ALIGNMENT);
+        unsigned char *staging = recorder.stagingData + offset;
+
+        // lz4 matches read back decompressed bytes, which is very slow on
+        // write-combined upload memory. so chunks are decompressed into a
+        // cache-resident scratch buffer and then streamed into staging memory
+
+        std::atomic<uint32_t> nextChunk = chunkBeg;
+        std::atomic<bool>     isCorrupted = false;
+
+        auto decompressChunks = [&](int)
+        {
+            std::vector<unsigned char> scratch;
+
+            for(;;)
+            {
+                const uint32_t i = nextChunk++;
+                if(i >= chunkEnd)
+                    return;
+
+                const auto chunk = src.getChunk(i);
+                unsigned char *out =
+                    staging + (chunk.decompressedOffset - byteBeg);
+
+                if(chunk.isStored())
+                {
+                    std::memcpy(out, chunk.data, chunk.decompressedSize);
+                    continue;
+                }
+
+                scratch.resize(chunk.decompressedSize);
+                if(!lz4Decompress(
+                    chunk.data, chunk.compressedSize,
+                    scratch.data(), chunk.decompressedSize))
+                {
+                    isCorrupted = true;
+                    return;
+                }
+
+                std::memcpy(out, scratch.data(), chunk.decompressedSize);
+            }
+        };
+
+        const int threadCount = (std::min)(
+            decompressThreadCount_, static_cast<int>(chunkEnd - chunkBeg));
+
+        if(parallel && threadCount > 1)
+            decompressThreadGroup_->run(threadCount, decompressChunks);
+        else
+            decompressChunks(0);
+
+        // staging space is only retired after a submission. so the recorder
+        // is marked dirty before throwing, making the next allocation submit
+        // and reclaim the space instead of failing on a ring it can't retire
+
+        if(isCorrupted)
+        {
+            recorder.isCopyCmdListDirty = true;
+            throw D3D12LabException(
+                "resource uploader: corrupted compressed data");
+        }
+
+        recorder.getCurCmdList().copyCmdList->CopyBufferRegion(
+            dst, dstOffset + byteBeg,
+            recorder.stagingBuffer.Get(), offset, byteEnd - byteBeg);
+
+        recorder.isCopyCmdListDirty = true;
+    }
+}
+
+void ResourceUploader::recordTransition(
+    Recorder             &recorder,
+    ID3D12Resource       *rsc,
+    D3D12_RESOURCE_STATES afterState)
+{
+    // rscs accessed on copy queue decay to COMMON, which needs no transition.
+    // any other afterState is made the real state, since callers (e.g. the
+    // frame graph with external rscs) record barriers from it
+
+    if(afterState == D3D12_RESOURCE_STATE_COMMON)
+        return;
+
+    recorder.pendingBarriers.push_back(
+        CD3DX12_RESOURCE_BARRIER::Transition(
+            rsc, D3D12_RESOURCE_STATE_COMMON, afterState));
+}
+
+void ResourceUploader::addUploadingRsc(
+    Recorder &recorder, ComPtr<ID3D12Resource> rsc)
+{
+    recorder.recordedRscs.push_back(std::move(rsc));
+}
+
+UINT64 ResourceUploader::submitRecorder(Recorder &recorder)
+{
+    const bool isMain = &recorder == mainRecorder_.get();
+
+    // residency manager is only used on the thread owning the uploader
+
+    if(isMain && residencyMgr_)
+    {
+        trackPendingResidency();
+        residencyMgr_->makeResident();
+    }
+
+    auto &cur = recorder.getCurCmdList();
+
+    if(!recorder.pendingBarriers.empty())
+    {
+        cur.graphicsCmdList->ResourceBarrier(
+            static_cast<UINT>(recorder.pendingBarriers.size()),
+            recorder.pendingBarriers.data());
+
+        recorder.pendingBarriers.clear();
+        recorder.isGraphicsCmdListDirty = true;
+    }
+
+    ID3D12CommandList *rawCopyCmdLists[]     = { cur.copyCmdList };
+    ID3D12CommandList *rawGraphicsCmdLists[] = { cur.graphicsCmdList };
+
+    cur.copyCmdList    ->Close();
+    cur.graphicsCmdList->Close();
+
+    // submissions of all recorders are serialized, so finish fence values
+    // are signaled in increasing order
+
+    UINT64 fenceValue;
+    {
+        std::lock_guard lk(submitMutex_);
+
+        fenceValue = nextExpectedFinishFenceValue_++;
+
+        if(!isMain && residencyMgr_)
+        {
+            for(auto &rsc : recorder.recordedRscs)
+                pendingResidencyRscs_.push_back({ fenceValue, rsc });
+        }
+
+        if(recorder.isGraphicsCmdListDirty)
+        {
+            const UINT64 copyToGraphicsFenceValue =
+                nextExpectedCopyToGraphicsFenceValue_++;
+
+            copyQueue_->ExecuteCommandLists(1, rawCopyCmdLists);
+            copyQueue_->Signal(
+                copyToGraphicsFence_.Get(), copyToGraphicsFenceValue);
+
+            graphicsQueue_->Wait(
+                copyToGraphicsFence_.Get(), copyToGraphicsFenceValue);
+            graphicsQueue_->ExecuteCommandLists(1, rawGraphicsCmdLists);
+            graphicsQueue_->Signal(finishFence_.Get(), fenceValue);
+        }
+        else
+        {
+            copyQueue_->ExecuteCommandLists(1, rawCopyCmdLists);
+            copyQueue_->Signal(finishFence_.Get(), fenceValue);
+        }
+    }
+
+    // staging space and dsts used by current cmd lists are retired with
+    // their fence
+
+    recorder.stagingRing.endFrame(fenceValue);
+
+    if(isMain && residencyMgr_)
+    {
+        for(auto &rsc : recorder.recordedRscs)
+            pinnedRscs_.push_back({ fenceValue, rsc });
+    }
+
+    for(auto &rsc : recorder.recordedRscs)
+        recorder.uploadingRscs.push_back({ fenceValue, std::move(rsc) });
+    recorder.recordedRscs.clear();
+
+    cur.expectedFenceValue  = fenceValue;
+    recorder.lastFenceValue = fenceValue;
+
     // switch to next cmd lists
 
-    curCmdListIdx_ = (curCmdListIdx_ + 1) % copyCmdLists_.size();
+    recorder.curCmdListIdx =
+        (recorder.curCmdListIdx + 1) % recorder.cmdLists.size();
 
-    finishFence_->SetEventOnCompletion(
-        copyCmdLists_[curCmdListIdx_].expectedFenceValue, nullptr);
-    finishFence_->SetEventOnCompletion(
-        graphicsCmdLists_[curCmdListIdx_].expectedFenceValue, nullptr);
+    auto &next = recorder.getCurCmdList();
+    finishFence_->SetEventOnCompletion(next.expectedFenceValue, nullptr);
 
-    copyCmdLists_[curCmdListIdx_].expectedFenceValue =
-        nextExpectedFinishFenceValue_;
-    graphicsCmdLists_[curCmdListIdx_].expectedFenceValue =
-        nextExpectedFinishFenceValue_;
+    next.copyCmdList    .resetCommandList();
+    next.graphicsCmdList.resetCommandList();
 
-    copyCmdLists_    [curCmdListIdx_].cmdList.resetCommandList();
-    graphicsCmdLists_[curCmdListIdx_].cmdList.resetCommandList();
+    recorder.isCopyCmdListDirty     = false;
+    recorder.isGraphicsCmdListDirty = false;
 
-    isCurCmdListDirty_         = false;
-    isCurGraphicsCmdListDirty_ = false;
+    return fenceValue;
 }
 
-void ResourceUploader::collect()
+void ResourceUploader::retireRecorder(
+    Recorder &recorder, UINT64 completedFenceValue)
 {
-    std::vector<UploadingRsc> newRscs;
-    for(auto &rsc : uploadingRscs_)
+    recorder.stagingRing.retire(completedFenceValue);
+
+    std::vector<Recorder::UploadingRsc> newRscs;
+    for(auto &rsc : recorder.uploadingRscs)
     {
-        if(finishFence_->GetCompletedValue() < rsc.expectedFenceValue)
+        if(completedFenceValue < rsc.expectedFenceValue)
             newRscs.push_back(std::move(rsc));
     }
-    uploadingRscs_.swap(newRscs);
+    recorder.uploadingRscs.swap(newRscs);
 }
 
-void ResourceUploader::waitForIdle()
+void ResourceUploader::useResidency(ComPtr<ID3D12Resource> dst)
 {
-    if(isCurCmdListDirty_)
-        submit();
+    if(!residencyMgr_)
+        return;
 
-    for(size_t i = 0; i < copyCmdLists_.size(); ++i)
-    {
-        if(i == curCmdListIdx_)
-            continue;
+    // copy queue signals no use point of the manager, so dsts are pinned
+    // until their copies are finished
+
+    ID3D12Pageable *pageable = dst.Get();
+    residencyMgr_->track(std::move(dst), true);
+    residencyMgr_->pin(pageable);
+    residencyMgr_->use(pageable);
+}
+
+void ResourceUploader::trackPendingResidency()
+{
+    if(!residencyMgr_)
+        return;
 
-        finishFence_->SetEventOnCompletion(
-            copyCmdLists_[i].expectedFenceValue, nullptr);
+    std::vector<PinnedRsc> rscs;
+    {
+        std::lock_guard lk(submitMutex_);
+        rscs.swap(pendingResidencyRscs_);
+    }
 
-        finishFence_->SetEventOnCompletion(
-            graphicsCmdLists_[i].expectedFenceValue, nullptr);
+    for(auto &rsc : rscs)
+    {
+        useResidency(rsc.rsc);
+        pinnedRscs_.push_back(std::move(rsc));
     }
+}
 
-    collect();
+void ResourceUploader::unpinFinishedRscs(UINT64 completedFenceValue)
+{
+    if(!residencyMgr_)
+        return;
+
+    std::vector<PinnedRsc> newRscs;
+    for(auto &rsc : pinnedRscs_)
+    {
+        if(completedFenceValue < rsc.expectedFenceValue)
+            newRscs.push_back(std::move(rsc));
+        else
+            residencyMgr_->unpin(rsc.rsc.Get());
+    }
+    pinnedRscs_.swap(newRscs);
 }
 
 AGZ_D3D12_END
@@ -0,0 +1,256 @@
+#include <algorithm>
+
+#include <d3dx12.h>
+
+#include <agz/d3d12/asset/xxHash64.h>
+#include <agz/d3d12/sync/uploadCache.h>
+
+AGZ_D3D12_BEGIN
+
+namespace
+{
+    bool isSameDesc(
+        const D3D12_RESOURCE_DESC &lhs, const D3D12_RESOURCE_DESC &rhs) noexcept
+    {
+        return lhs.Dimension          == rhs.Dimension          &&
+               lhs.Alignment          == rhs.Alignment          &&
+               lhs.Width              == rhs.Width              &&
+               lhs.Height             == rhs.Height             &&
+               lhs.DepthOrArraySize   == rhs.DepthOrArraySize   &&
+               lhs.MipLevels          == rhs.MipLevels          &&
+               lhs.Format             == rhs.Format             &&
+               lhs.SampleDesc.Count   == rhs.SampleDesc.Count   &&
+               lhs.SampleDesc.Quality == rhs.SampleDesc.Quality &&
+               lhs.Layout             == rhs.Layout             &&
+               lhs.Flags              == rhs.Flags;
+    }
+
+    UINT16 getFullMipCount(UINT64 width, UINT height) noexcept
+    {
+        UINT16 ret = 1;
+        for(UINT64 s = (std::max)(width, UINT64(height)); s > 1; s >>= 1)
+            ++ret;
+        return ret;
+    }
+
+    // seed of the check hash, which is compared besides the key hash
+    constexpr uint64_t CHECK_SEED = 0x5bd1e9955bd1e995ull;
+
+} // namespace anonymous
+
+UploadCache::UploadCache(
+    ComPtr<ID3D12Device> device, ResourceUploader &uploader)
+    : device_(std::move(device)), uploader_(uploader)
+{
+
+}
+
+ComPtr<ID3D12Resource> UploadCache::acquireBuffer(
+    const void           *data,
+    size_t                byteSize,
+    D3D12_RESOURCE_STATES afterState,
+    D3D12_RESOURCE_FLAGS  flags)
+{
+    const D3D12_RESOURCE_DESC desc =
+        resolveDesc(CD3DX12_RESOURCE_DESC::Buffer(byteSize, flags));
+
+    ContentHash hash;
+    hash.key   = xxHash64(data, byteSize);
+    hash.check = xxHash64(data, byteSize, CHECK_SEED);
+
+    if(auto rsc = acquireExisting(hash, desc, afterState))
+        return rsc;
+
+    // an entry whose upload failed must not be hit later
+
+    auto rsc = createEntry(hash, desc, afterState);
+    misc::scope_guard_t releaseGuard([&] { release(rsc.Get()); });
+
+    uploader_.uploadBufferData(rsc, data, byteSize, afterState);
+
+    releaseGuard.dismiss();
+    return rsc;
+}
+
+ComPtr<ID3D12Resource> UploadCache::acquireTex2D(
+    const D3D12_RESOURCE_DESC             &desc,
+    const ResourceUploader::Tex2DInitData &initData,
+    D3D12_RESOURCE_STATES                  afterState)
+{
+    // hash and compare the desc the rsc is created with, e.g. with the full
+    // mip count instead of 0
+
+    const D3D12_RESOURCE_DESC resolvedDesc = resolveDesc(desc);
+    const ContentHash hash = hashTex2D(resolvedDesc, initData);
+
+    if(auto rsc = acquireExisting(hash, resolvedDesc, afterState))
+        return rsc;
+
+    auto rsc = createEntry(hash, resolvedDesc, afterState);
+    misc::scope_guard_t releaseGuard([&] { release(rsc.Get()); });
+
+    uploader_.uploadTex2DData(rsc, initData, afterState);
+
+    releaseGuard.dismiss();
+    return rsc;
+}
+
+ComPtr<ID3D12Resource> UploadCache::acquireTex2D(
+    const D3D12_RESOURCE_DESC                &desc,
+    const ResourceUploader::Tex2DSubInitData &initData,
+    D3D12_RESOURCE_STATES                     afterState)
+{
+    return acquireTex2D(
+        desc, ResourceUploader::Tex2DInitData{ &initData }, afterState);
+}
+
+void UploadCache::release(ID3D12Resource *rsc)
+{
+    const auto hashIt = rscToHash_.find(rsc);
+    if(hashIt == rscToHash_.end())
+        throw D3D12LabException("upload cache: releasing unknown resource");
+
+    const auto entriesIt = hashToEntries_.find(hashIt->second.key);
+    auto &entries = entriesIt->second;
+
+    const auto it = std::find_if(
+        entries.begin(), entries.end(),
+        [&](const Entry &entry) { return entry.rsc.Get() == rsc; });
+    if(--it->refCount)
+        return;
+
+    entries.erase(it);
+    if(entries.empty())
+        hashToEntries_.erase(entriesIt);
+
+    rscToHash_.erase(hashIt);
+    --stats_.entryCount;
+}
+
+UploadCache::Stats UploadCache::getStats() const noexcept
+{
+    return stats_;
+}
+
+D3D12_RESOURCE_DESC UploadCache::resolveDesc(
+    const D3D12_RESOURCE_DESC &desc) const
+{
+    D3D12_RESOURCE_DESC ret = desc;
+
+    if(ret.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D && !ret.MipLevels)
+        ret.MipLevels = getFullMipCount(ret.Width, ret.Height);
+
+    if(!ret.Alignment)
+    {
+        ret.Alignment =
+            device_->GetResourceAllocationInfo(0, 1, &ret).Alignment;
+    }
+
+    return ret;
+}
+
+UploadCache::ContentHash UploadCache::hashTex2D(
+    const D3D12_RESOURCE_DESC             &desc,
+    const ResourceUploader::Tex2DInitData &initData) const
+{
+    // hash the bytes the uploader copies, skipping the padding of rows in
+    // source data
+
+    XXHash64 hasher;
+    XXHash64 checkHasher(CHECK_SEED);
+
+    const UINT subrscCount = desc.DepthOrArraySize * desc.MipLevels;
+    for(UINT subrscIdx = 0; subrscIdx < subrscCount; ++subrscIdx)
+    {
+        UINT   rowCount;
+        UINT64 rowSize;
+        device_->GetCopyableFootprints(
+            &desc, subrscIdx, 1, 0, nullptr, &rowCount, &rowSize, nullptr);
+
+        const auto &iData = initData.subrscInitData[subrscIdx];
+        const UINT64 srcRowPitch = iData.rowSize ? iData.rowSize : rowSize;
+        auto srcData = static_cast<const unsigned char *>(iData.data);
+
+        if(srcRowPitch == rowSize)
+        {
+            const size_t size = static_cast<size_t>(rowCount * rowSize);
+            hasher.update(srcData, size);
+            checkHasher.update(srcData, size);
+            continue;
+        }
+
+        for(UINT r = 0; r < rowCount; ++r)
+        {
+            const unsigned char *row = srcData + r * srcRowPitch;
+            hasher.update(row, static_cast<size_t>(rowSize));
+            checkHasher.update(row, static_cast<size_t>(rowSize));
+        }
+    }
+
+    ContentHash ret;
+    ret.key   = hasher.digest();
+    ret.check = checkHasher.digest();
+    return ret;
+}
+
+ComPtr<ID3D12Resource> UploadCache::acquireExisting(
+    const ContentHash         &hash,
+    const D3D12_RESOURCE_DESC &desc,
+    D3D12_RESOURCE_STATES      afterState)
+{
+    const auto it = hashToEntries_.find(hash.key);
+    if(it == hashToEntries_.end())
+        return nullptr;
+
+    for(auto &entry : it->second)
+    {
+        if(entry.checkHash != hash.check || entry.afterState != afterState ||
+           !isSameDesc(entry.desc, desc))
+            continue;
+
+        ++entry.refCount;
+
+        ++stats_.hitCount;
+        stats_.savedBytes += entry.byteSize;
+
+        return entry.rsc;
+    }
+
+    return nullptr;
+}
+
+ComPtr<ID3D12Resource> UploadCache::createEntry(
+    const ContentHash         &hash,
+    const D3D12_RESOURCE_DESC &desc,
+    D3D12_RESOURCE_STATES      afterState)
+{
+    ComPtr<ID3D12Resource> rsc;
+    AGZ_D3D12_CHECK_HR(
+        device_->CreateCommittedResource(
+            get_temp_ptr(CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT)),
+            D3D12_HEAP_FLAG_NONE,
+            &desc,
+            D3D12_RESOURCE_STATE_COMMON,
+            nullptr,
+            IID_PPV_ARGS(rsc.GetAddressOf())));
+
+    const auto allocInfo = device_->GetResourceAllocationInfo(0, 1, &desc);
+
+    Entry entry;
+    entry.checkHash  = hash.check;
+    entry.desc       = desc;
+    entry.afterState = afterState;
+    entry.rsc        = rsc;
+    entry.byteSize   = allocInfo.SizeInBytes;
+    entry.refCount   = 1;
+
+    hashToEntries_[hash.key].push_back(std::move(entry));
+    rscToHash_[rsc.Get()] = hash;
+
+    ++stats_.missCount;
+    ++stats_.entryCount;
+
+    return rsc;
+}
+
+AGZ_D3D12_END
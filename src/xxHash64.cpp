@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cstring>
+
+#include <agz/d3d12/asset/xxHash64.h>
+
+AGZ_D3D12_BEGIN
+
+namespace
+{
+    constexpr uint64_t PRIME1 = 0x9e3779b185ebca87ull;
+    constexpr uint64_t PRIME2 = 0xc2b2ae3d27d4eb4full;
+    constexpr uint64_t PRIME3 = 0x165667b19e3779f9ull;
+    constexpr uint64_t PRIME4 = 0x85ebca77c2b2ae63ull;
+    constexpr uint64_t PRIME5 = 0x27d4eb2f165667c5ull;
+
+    uint64_t rotl(uint64_t x, int r) noexcept
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    uint64_t read64(const unsigned char *p) noexcept
+    {
+        uint64_t ret;
+        std::memcpy(&ret, p, sizeof(ret));
+        return ret;
+    }
+
+    uint32_t read32(const unsigned char *p) noexcept
+    {
+        uint32_t ret;
+        std::memcpy(&ret, p, sizeof(ret));
+        return ret;
+    }
+
+    uint64_t round(uint64_t acc, uint64_t input) noexcept
+    {
+        acc += input * PRIME2;
+        acc  = rotl(acc, 31);
+        return acc * PRIME1;
+    }
+
+    uint64_t mergeRound(uint64_t acc, uint64_t val) noexcept
+    {
+        acc ^= round(0, val);
+        return acc * PRIME1 + PRIME4;
+    }
+
+    // consume 32-byte stripes with four independent lanes
+    const unsigned char *consumeStripes(
+        uint64_t             acc[4],
+        const unsigned char *p,
+        const unsigned char *end) noexcept
+    {
+        for(; end - p >= 32; p += 32)
+        {
+            acc[0] = round(acc[0], read64(p));
+            acc[1] = round(acc[1], read64(p + 8));
+            acc[2] = round(acc[2], read64(p + 16));
+            acc[3] = round(acc[3], read64(p + 24));
+        }
+        return p;
+    }
+
+} // namespace anonymous
+
+XXHash64::XXHash64(uint64_t seed) noexcept
+{
+    reset(seed);
+}
+
+void XXHash64::reset(uint64_t seed) noexcept
+{
+    acc_[0] = seed + PRIME1 + PRIME2;
+    acc_[1] = seed + PRIME2;
+    acc_[2] = seed;
+    acc_[3] = seed - PRIME1;
+
+    seed_       = seed;
+    totalSize_  = 0;
+    bufferSize_ = 0;
+}
+
+void XXHash64::update(const void *data, size_t byteSize) noexcept
+{
+    auto p   = static_cast<const unsigned char *>(data);
+    auto end = p + byteSize;
+
+    totalSize_ += byteSize;
+
+    // fill the partial stripe left by last call
+
+    if(bufferSize_)
+    {
+        const size_t n = (std::min)(byteSize, sizeof(buffer_) - bufferSize_);
+        std::memcpy(buffer_ + bufferSize_, p, n);
+        bufferSize_ += n;
+        p += n;
+
+        if(bufferSize_ < sizeof(buffer_))
+            return;
+
+        consumeStripes(acc_, buffer_, buffer_ + sizeof(buffer_));
+        bufferSize_ = 0;
+    }
+
+    p = consumeStripes(acc_, p, end);
+
+    if(p != end)
+    {
+        bufferSize_ = static_cast<size_t>(end - p);
+        std::memcpy(buffer_, p, bufferSize_);
+    }
+}
+
+uint64_t XXHash64::digest() const noexcept
+{
+    uint64_t h;
+    if(totalSize_ >= 32)
+    {
+        h = rotl(acc_[0], 1) + rotl(acc_[1], 7) +
+            rotl(acc_[2], 12) + rotl(acc_[3], 18);
+        for(uint64_t a : acc_)
+            h = mergeRound(h, a);
+    }
+    else
+        h = seed_ + PRIME5;
+
+    h += totalSize_;
+
+    // remaining bytes in buffer
+
+    const unsigned char *p   = buffer_;
+    const unsigned char *end = buffer_ + bufferSize_;
+
+    for(; end - p >= 8; p += 8)
+    {
+        h ^= round(0, read64(p));
+        h  = rotl(h, 27) * PRIME1 + PRIME4;
+    }
+
+    if(end - p >= 4)
+    {
+        h ^= uint64_t(read32(p)) * PRIME1;
+        h  = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+
+    for(; p != end; ++p)
+    {
+        h ^= *p * PRIME5;
+        h  = rotl(h, 11) * PRIME1;
+    }
+
+    // avalanche
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t xxHash64(const void *data, size_t byteSize, uint64_t seed) noexcept
+{
+    XXHash64 hasher(seed);
+    hasher.update(data, byteSize);
+    return hasher.digest();
+}
+
+AGZ_D3D12_END
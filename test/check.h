@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// checks stay enabled in release builds, unlike assert
+
+#define CHECK(COND)                                                            \
+    do                                                                         \
+    {                                                                          \
+        if(!(COND))                                                            \
+        {                                                                      \
+            std::fprintf(                                                      \
+                stderr, "%s:%d: check failed: %s\n",                           \
+                __FILE__, __LINE__, #COND);                                    \
+            std::exit(1);                                                      \
+        }                                                                      \
+    } while(false)
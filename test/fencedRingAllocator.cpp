@@ -0,0 +1,187 @@
+#include <random>
+#include <vector>
+
+#include <agz/d3d12/sync/fencedRingAllocator.h>
+
+#include "./check.h"
+
+using namespace agz::d3d12;
+
+namespace
+{
+    void testWrapAround()
+    {
+        FencedRingAllocator ring(1024);
+
+        CHECK(ring.alloc(100) == 0u);
+        CHECK(ring.alloc(100, 64) == 128u);
+        ring.endFrame(1);
+        CHECK(ring.alloc(500) == 228u);
+        ring.endFrame(2);
+        CHECK(ring.getUsedSize() == 728);
+
+        // space is not reused before its frame is retired
+
+        CHECK(!ring.alloc(400).has_value());
+        ring.retire(0);
+        CHECK(ring.getUsedSize() == 728);
+
+        ring.retire(1);
+        CHECK(ring.getUsedSize() == 500);
+        CHECK(ring.getOldestFenceValue() == 2u);
+
+        // allocations continue from head and wrap to the start
+
+        CHECK(ring.alloc(200) == 728u);
+        CHECK(ring.alloc(200) == 0u);
+        CHECK(!ring.alloc(29).has_value());
+        CHECK(ring.alloc(28) == 200u);
+        CHECK(ring.getUsedSize() == 1024);
+    }
+
+    void testTailSkipping()
+    {
+        FencedRingAllocator ring(1024);
+
+        CHECK(ring.alloc(900) == 0u);
+        ring.endFrame(1);
+        CHECK(ring.alloc(50) == 900u);
+        ring.endFrame(2);
+        ring.retire(1);
+
+        // 200 bytes do not fit in the 74-byte tail, which is skipped and
+        // accounted as used until the frame is retired
+
+        CHECK(ring.alloc(200) == 0u);
+        CHECK(ring.getUsedSize() == 324);
+
+        CHECK(ring.alloc(700) == 200u);
+        CHECK(ring.getUsedSize() == 1024);
+        CHECK(!ring.alloc(1).has_value());
+
+        ring.endFrame(3);
+        ring.retire(3);
+        CHECK(ring.getUsedSize() == 0);
+
+        // an allocation larger than the ring never fits. an idle ring holds
+        // one of full size, wherever its head was
+
+        CHECK(!ring.alloc(1025).has_value());
+        CHECK(ring.alloc(1024) == 0u);
+    }
+
+    void testFenceRetirement()
+    {
+        FencedRingAllocator ring(1024);
+
+        CHECK(ring.alloc(256) == 0u);
+        ring.endFrame(1);
+        CHECK(ring.alloc(256) == 256u);
+        ring.endFrame(1);
+        CHECK(ring.alloc(256) == 512u);
+        ring.endFrame(3);
+
+        // frames are retired in order, as far as the completed value goes
+
+        ring.retire(2);
+        CHECK(ring.getUsedSize() == 256);
+        CHECK(ring.getOldestFenceValue() == 3u);
+
+        ring.retire(5);
+        CHECK(ring.getUsedSize() == 0);
+
+        // an empty frame retires nothing but keeps the fence order
+
+        ring.endFrame(6);
+        CHECK(ring.getOldestFenceValue() == 6u);
+        ring.retire(6);
+        CHECK(!ring.getOldestFenceValue().has_value());
+    }
+
+    void testRandom()
+    {
+        constexpr uint64_t CAPACITY = 4096;
+
+        struct Allocation
+        {
+            uint64_t fenceValue;
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        FencedRingAllocator ring(CAPACITY);
+
+        std::mt19937 rng(7);
+
+        // allocations of unretired frames. UINT64_MAX for the current frame
+        std::vector<Allocation> live;
+        uint64_t nextFenceValue = 1, completedFenceValue = 0;
+
+        for(int iter = 0; iter < 20000; ++iter)
+        {
+            const int op = rng() % 8;
+            if(op < 5)
+            {
+                const uint64_t size      = 1 + rng() % 1024;
+                const uint64_t alignment = uint64_t(1) << (rng() % 9);
+
+                const auto offset = ring.alloc(size, alignment);
+                if(!offset)
+                {
+                    // a full ring only makes progress by retiring
+                    CHECK(!live.empty());
+                    continue;
+                }
+
+                CHECK(*offset % alignment == 0);
+                CHECK(*offset + size <= CAPACITY);
+
+                for(auto &a : live)
+                {
+                    CHECK(*offset + size <= a.offset ||
+                          a.offset + a.size <= *offset);
+                }
+
+                live.push_back({ UINT64_MAX, *offset, size });
+            }
+            else if(op < 7)
+            {
+                for(auto &a : live)
+                {
+                    if(a.fenceValue == UINT64_MAX)
+                        a.fenceValue = nextFenceValue;
+                }
+                ring.endFrame(nextFenceValue++);
+            }
+            else
+            {
+                completedFenceValue +=
+                    rng() % (nextFenceValue - completedFenceValue);
+                ring.retire(completedFenceValue);
+
+                std::vector<Allocation> newLive;
+                for(auto &a : live)
+                {
+                    if(a.fenceValue > completedFenceValue)
+                        newLive.push_back(a);
+                }
+                live.swap(newLive);
+            }
+
+            uint64_t liveSize = 0;
+            for(auto &a : live)
+                liveSize += a.size;
+            CHECK(ring.getUsedSize() >= liveSize);
+            CHECK(ring.getUsedSize() <= CAPACITY);
+        }
+    }
+
+} // namespace anonymous
+
+int main()
+{
+    testWrapAround();
+    testTailSkipping();
+    testFenceRetirement();
+    testRandom();
+}
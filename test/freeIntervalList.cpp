@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <agz/d3d12/descriptor/freeIntervalList.h>
+
+#include "./check.h"
+
+using namespace agz::d3d12;
+
+namespace
+{
+    constexpr uint32_t SPACE_SIZE = 4096;
+
+    struct Run
+    {
+        uint32_t beg;
+        uint32_t end;
+    };
+
+    // maximal runs of free slots in the reference model
+    std::vector<Run> getFreeRuns(const std::vector<bool> &isFree)
+    {
+        std::vector<Run> ret;
+        for(uint32_t i = 0; i < SPACE_SIZE;)
+        {
+            if(!isFree[i])
+            {
+                ++i;
+                continue;
+            }
+
+            uint32_t end = i;
+            while(end < SPACE_SIZE && isFree[end])
+                ++end;
+            ret.push_back({ i, end });
+            i = end;
+        }
+        return ret;
+    }
+
+    void checkStats(
+        const FreeIntervalList<uint32_t> &list,
+        const std::vector<bool>          &isFree)
+    {
+        const auto runs = getFreeRuns(isFree);
+
+        uint32_t freeCount = 0, largest = 0;
+        for(auto &r : runs)
+        {
+            freeCount += r.end - r.beg;
+            largest    = (std::max)(largest, r.end - r.beg);
+        }
+
+        // adjacent free intervals are always merged, so the list holds
+        // exactly the maximal runs
+
+        const auto stats = list.getStats();
+        CHECK(stats.freeCount        == freeCount);
+        CHECK(stats.largestFreeBlock == largest);
+        CHECK(stats.freeBlockCount   == runs.size());
+    }
+
+    // returns the run containing slot idx
+    const Run *findRun(const std::vector<Run> &runs, uint32_t idx)
+    {
+        for(auto &r : runs)
+        {
+            if(r.beg <= idx && idx < r.end)
+                return &r;
+        }
+        return nullptr;
+    }
+
+    void testRandom(bool lowest)
+    {
+        FreeIntervalList<uint32_t> list;
+        list.free(0, SPACE_SIZE);
+
+        std::vector<bool> isFree(SPACE_SIZE, true);
+        std::vector<Run>  live;
+
+        std::mt19937 rng(lowest ? 1 : 2);
+        std::uniform_int_distribution<uint32_t> countDis(1, 64);
+
+        for(int iter = 0; iter < 10000; ++iter)
+        {
+            if(live.empty() || rng() % 2)
+            {
+                const uint32_t count = countDis(rng);
+                const auto runs = getFreeRuns(isFree);
+
+                const auto obeg = lowest ? list.allocLowest(count)
+                                         : list.alloc(count);
+
+                // expected run: the first one fitting for allocLowest, the
+                // smallest one fitting for best-fit alloc
+
+                const Run *expected = nullptr;
+                for(auto &r : runs)
+                {
+                    if(r.end - r.beg < count)
+                        continue;
+                    if(!expected || (!lowest &&
+                       r.end - r.beg < expected->end - expected->beg))
+                        expected = &r;
+                    if(lowest)
+                        break;
+                }
+
+                CHECK(obeg.has_value() == (expected != nullptr));
+                if(!obeg)
+                    continue;
+
+                const Run *run = findRun(runs, *obeg);
+                CHECK(run && run->beg == *obeg);
+                CHECK(run->end - run->beg ==
+                      expected->end - expected->beg);
+                if(lowest)
+                    CHECK(run == expected);
+
+                for(uint32_t i = *obeg; i < *obeg + count; ++i)
+                    isFree[i] = false;
+                live.push_back({ *obeg, *obeg + count });
+            }
+            else
+            {
+                // free a whole live interval or only part of it
+
+                const size_t idx = rng() % live.size();
+                Run r = live[idx];
+
+                if(rng() % 4 == 0 && r.end - r.beg > 1)
+                {
+                    const uint32_t mid =
+                        r.beg + 1 + rng() % (r.end - r.beg - 1);
+                    live[idx].beg = mid;
+                    r.end = mid;
+                }
+                else
+                {
+                    live[idx] = live.back();
+                    live.pop_back();
+                }
+
+                list.free(r.beg, r.end);
+                for(uint32_t i = r.beg; i < r.end; ++i)
+                    isFree[i] = true;
+            }
+
+            checkStats(list, isFree);
+        }
+
+        // freeing everything merges back into one interval
+
+        for(auto &r : live)
+            list.free(r.beg, r.end);
+
+        const auto stats = list.getStats();
+        CHECK(stats.freeCount == SPACE_SIZE);
+        CHECK(stats.freeBlockCount == 1);
+        CHECK(list.alloc(SPACE_SIZE) == 0u);
+    }
+
+} // namespace anonymous
+
+int main()
+{
+    testRandom(false);
+    testRandom(true);
+}
@@ -0,0 +1,155 @@
+#include <agz/d3d12/memory/residencyTracker.h>
+
+#include "./check.h"
+
+using namespace agz::d3d12;
+
+namespace
+{
+    // budget source driven by the test instead of dxgi
+    class FakeBudgetSource : public BudgetSource
+    {
+    public:
+
+        UINT64 budget = 0;
+        UINT64 usage  = 0;
+
+        UINT64 getBudget() override { return budget; }
+
+        UINT64 getUsage() override { return usage; }
+    };
+
+    int objs[4];
+
+    ResidencyTracker::Key key(int i)
+    {
+        return &objs[i];
+    }
+
+    // evict like ResidencyManager::enforceBudget and account the result in
+    // the fake usage
+    std::vector<ResidencyTracker::Key> enforceBudget(
+        ResidencyTracker &tracker,
+        FakeBudgetSource &source,
+        UINT64            completedFenceValue)
+    {
+        if(source.getUsage() <= source.getBudget())
+            return {};
+
+        auto evicted = tracker.evictToBudget(
+            source.getUsage(), source.getBudget(), completedFenceValue);
+        source.usage = tracker.getResidentBytes();
+        return evicted;
+    }
+
+    void testFence()
+    {
+        ResidencyTracker tracker;
+        FakeBudgetSource source;
+
+        for(int i = 0; i < 4; ++i)
+        {
+            tracker.add(key(i), 100, false);
+            tracker.use(key(i), UINT64(i + 1));
+        }
+        source.usage  = 400;
+        source.budget = 250;
+
+        // nothing is evictable before gpu reaches any use
+
+        CHECK(enforceBudget(tracker, source, 0).empty());
+        CHECK(tracker.getResidentBytes() == 400);
+
+        // only objects whose last use is finished are chosen, lru first
+
+        auto evicted = enforceBudget(tracker, source, 1);
+        CHECK(evicted.size() == 1 && evicted[0] == key(0));
+        CHECK(!tracker.isResident(key(0)));
+
+        evicted = enforceBudget(tracker, source, 4);
+        CHECK(evicted.size() == 1 && evicted[0] == key(1));
+        CHECK(source.usage == 200);
+        CHECK(tracker.getEvictedBytes() == 200);
+
+        // using an evicted object makes it resident again
+
+        CHECK(tracker.use(key(0), 5));
+        CHECK(!tracker.use(key(0), 5));
+        CHECK(tracker.isResident(key(0)));
+        CHECK(tracker.getResidentBytes() == 300);
+        CHECK(tracker.getEvictedBytes() == 100);
+
+        // a later use keeps the object until that use is finished
+
+        source.usage  = tracker.getResidentBytes();
+        source.budget = 0;
+        evicted = enforceBudget(tracker, source, 4);
+        CHECK(evicted.size() == 2);
+        CHECK(tracker.isResident(key(0)));
+
+        CHECK(enforceBudget(tracker, source, 5).size() == 1);
+        CHECK(tracker.getResidentBytes() == 0);
+    }
+
+    void testPin()
+    {
+        ResidencyTracker tracker;
+        FakeBudgetSource source;
+
+        tracker.add(key(0), 100, true);
+        tracker.add(key(1), 100, false);
+        tracker.pin(key(1));
+        tracker.pin(key(1));
+
+        source.usage  = 200;
+        source.budget = 0;
+
+        CHECK(tracker.isPinned(key(0)) && tracker.isPinned(key(1)));
+        CHECK(enforceBudget(tracker, source, 100).empty());
+
+        // pins are counted
+
+        tracker.unpin(key(1));
+        CHECK(enforceBudget(tracker, source, 100).empty());
+
+        tracker.unpin(key(1));
+        auto evicted = enforceBudget(tracker, source, 100);
+        CHECK(evicted.size() == 1 && evicted[0] == key(1));
+
+        tracker.unpin(key(0));
+        CHECK(!tracker.isPinned(key(0)));
+        CHECK(enforceBudget(tracker, source, 100).size() == 1);
+    }
+
+    void testRemove()
+    {
+        ResidencyTracker tracker;
+        FakeBudgetSource source;
+
+        tracker.add(key(0), 100, false);
+        tracker.add(key(1), 50, false);
+
+        source.usage  = 150;
+        source.budget = 40;
+        CHECK(enforceBudget(tracker, source, 0).size() == 2);
+
+        tracker.remove(key(0));
+        CHECK(!tracker.contains(key(0)));
+        CHECK(tracker.getEvictedBytes() == 50);
+
+        // untracked keys are ignored
+
+        CHECK(!tracker.use(key(0), 1));
+        tracker.pin(key(0));
+        tracker.unpin(key(0));
+        CHECK(!tracker.isPinned(key(0)));
+    }
+
+} // namespace anonymous
+
+int main()
+{
+    testFence();
+    testPin();
+    testRemove();
+}
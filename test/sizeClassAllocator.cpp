@@ -0,0 +1,136 @@
+#include <random>
+#include <vector>
+
+#include <agz/d3d12/buffer/sizeClassAllocator.h>
+
+#include "./check.h"
+
+using namespace agz::d3d12;
+
+namespace
+{
+    constexpr uint64_t BLOCK_SIZE = 4096;
+    constexpr uint64_t MIN_CLASS  = 16;
+    constexpr uint64_t MAX_CLASS  = 1024;
+
+    SizeClassAllocator::Allocation allocOrGrow(
+        SizeClassAllocator &allocator, uint64_t size)
+    {
+        if(auto ret = allocator.alloc(size))
+            return *ret;
+        allocator.addBlock();
+        auto ret = allocator.alloc(size);
+        CHECK(ret.has_value());
+        return *ret;
+    }
+
+    void testClasses()
+    {
+        SizeClassAllocator allocator(BLOCK_SIZE, MIN_CLASS, MAX_CLASS);
+
+        CHECK(allocator.getClassIndex(1)    == 0);
+        CHECK(allocator.getClassIndex(16)   == 0);
+        CHECK(allocator.getClassIndex(17)   == 1);
+        CHECK(allocator.getClassIndex(1024) == 6);
+
+        CHECK(allocator.isSuballocatable(MAX_CLASS));
+        CHECK(!allocator.isSuballocatable(MAX_CLASS + 1));
+
+        // no block yet
+
+        CHECK(!allocator.alloc(1).has_value());
+    }
+
+    void testBlockReuse()
+    {
+        SizeClassAllocator allocator(BLOCK_SIZE, MIN_CLASS, MAX_CLASS);
+        allocator.addBlock();
+
+        // fill the block with one class
+
+        std::vector<SizeClassAllocator::Allocation> allocs;
+        for(uint64_t i = 0; i < BLOCK_SIZE / 64; ++i)
+        {
+            auto a = allocator.alloc(64);
+            CHECK(a.has_value());
+            CHECK(a->block == 0 && a->size == 64 && a->offset % 64 == 0);
+            allocs.push_back(*a);
+        }
+        CHECK(!allocator.alloc(64).has_value());
+        CHECK(allocator.getLiveCount(0) == BLOCK_SIZE / 64);
+
+        // an emptied block serves another class
+
+        for(auto &a : allocs)
+            allocator.free(a);
+        CHECK(allocator.getEmptyBlockCount() == 1);
+
+        auto big = allocator.alloc(MAX_CLASS);
+        CHECK(big.has_value() && big->block == 0 && big->offset == 0);
+        CHECK(allocator.getEmptyBlockCount() == 0);
+    }
+
+    void testRandom()
+    {
+        SizeClassAllocator allocator(BLOCK_SIZE, MIN_CLASS, MAX_CLASS);
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<uint64_t> sizeDis(1, MAX_CLASS);
+
+        std::vector<SizeClassAllocator::Allocation> live;
+
+        // byte ownership of all blocks, checking that live slots never overlap
+
+        std::vector<std::vector<int>> owners;
+        auto mark = [&](const SizeClassAllocator::Allocation &a, int owner)
+        {
+            if(owners.size() <= a.block)
+                owners.resize(a.block + 1, std::vector<int>(BLOCK_SIZE, -1));
+            for(uint64_t i = a.offset; i < a.offset + a.size; ++i)
+            {
+                CHECK((owner < 0) != (owners[a.block][i] < 0));
+                owners[a.block][i] = owner;
+            }
+        };
+
+        for(int iter = 0; iter < 20000; ++iter)
+        {
+            if(live.empty() || rng() % 3)
+            {
+                const uint64_t size = sizeDis(rng);
+                const auto a = allocOrGrow(allocator, size);
+
+                CHECK(a.size >= size && a.size < 2 * size + MIN_CLASS);
+                CHECK(a.offset % a.size == 0);
+                CHECK(a.offset + a.size <= BLOCK_SIZE);
+
+                mark(a, iter);
+                live.push_back(a);
+            }
+            else
+            {
+                const size_t idx = rng() % live.size();
+                mark(live[idx], -1);
+                allocator.free(live[idx]);
+                live[idx] = live.back();
+                live.pop_back();
+            }
+        }
+
+        // every block is empty again after freeing everything
+
+        for(auto &a : live)
+            allocator.free(a);
+        CHECK(allocator.getEmptyBlockCount() == allocator.getBlockCount());
+        for(uint32_t b = 0; b < allocator.getBlockCount(); ++b)
+            CHECK(allocator.getLiveCount(b) == 0);
+    }
+
+} // namespace anonymous
+
+int main()
+{
+    testClasses();
+    testBlockReuse();
+    testRandom();
+}